@@ -0,0 +1,98 @@
+#include <iostream>
+#include <thread>
+#include <array>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include "benchmark_utils.h"
+
+#include "bounded_sp_sc_queue.h"
+#include "fan_in_queue.h"
+
+namespace concurrent::benchmark::queue {
+
+    inline constexpr std::size_t kQueueCapacity = 1024;
+    inline constexpr std::size_t kBulkSize = 64;
+
+    // The consumer polls all rings round-robin and touches the indices of the empty rings too
+    template<std::size_t QueuesCount>
+    class NaivePollingQueue {
+    public:
+        bool Enqueue(std::size_t producer, int element) {
+            return queues_[producer].Enqueue(element);
+        }
+
+        std::size_t DequeueBulk(std::vector<int>::iterator out, std::size_t max_count) {
+            std::size_t count = 0;
+            for (std::size_t i = 0; i < QueuesCount && count < max_count; ++i) {
+                count += queues_[i].DequeueBulk(out + count, max_count - count);
+            }
+            return count;
+        }
+
+    private:
+        std::array<concurrent::queue::BoundedSPSCQueue<int, kQueueCapacity>, QueuesCount> queues_;
+    };
+
+    template<std::size_t QueuesCount>
+    using FanInQueue = concurrent::queue::FanInQueue<int, QueuesCount, kQueueCapacity>;
+
+    // One producer thread writes to the first active_count rings in turn, so every ring still has one producer.
+    // With the small active_count most of the rings are empty and the consumer pays for scanning them
+    template<typename Queue>
+    void MeasureThroughput(const std::string& name, std::size_t queues_count, std::size_t active_count,
+                           const IterationsCount iterations, int producer_cpu, int consumer_cpu) {
+        Queue q{};
+
+        auto t = std::thread([&q, iterations, consumer_cpu] {
+            concurrent::benchmark::PinThread(consumer_cpu);
+            std::vector<int> bulk(kBulkSize);
+            for (IterationsCount i = 0; i < iterations;) {
+                i += static_cast<IterationsCount>(q.DequeueBulk(bulk.begin(), kBulkSize));
+            }
+        });
+
+        concurrent::benchmark::PinThread(producer_cpu);
+
+        auto start = std::chrono::steady_clock::now(); // Start measure the time
+
+        std::size_t producer = 0;
+        for (IterationsCount i = 0; i < iterations; ++i) {
+            while (!q.Enqueue(producer, static_cast<int>(i)));
+            producer = producer + 1 == active_count ? 0 : producer + 1;
+        }
+        t.join();
+
+        auto stop = std::chrono::steady_clock::now(); // Stop measure the time
+
+        std::cout << "Throughput of the " << name << " with " << active_count << " active rings of " << queues_count << ":" << std::endl;
+        std::cout << concurrent::benchmark::GetThroughput(iterations, start, stop) << " ops/ms" << std::endl;
+    }
+
+    template<std::size_t QueuesCount>
+    void MeasureFanIn(const IterationsCount iterations, int producer_cpu, int consumer_cpu) {
+        for (std::size_t active_count : {std::size_t{1}, QueuesCount}) {
+            MeasureThroughput<NaivePollingQueue<QueuesCount>>("naive polling", QueuesCount, active_count,
+                                                              iterations, producer_cpu, consumer_cpu);
+            MeasureThroughput<FanInQueue<QueuesCount>>("concurrent::queue::FanInQueue", QueuesCount, active_count,
+                                                       iterations, producer_cpu, consumer_cpu);
+        }
+    }
+
+} // End of namespace concurrent::benchmark::queue
+
+int main() {
+    int cpu1 = 0;
+    int cpu2 = 1;
+
+    const concurrent::benchmark::IterationsCount iterations = 1000000;
+
+    concurrent::benchmark::queue::MeasureFanIn<1>(iterations, cpu1, cpu2);
+    concurrent::benchmark::queue::MeasureFanIn<4>(iterations, cpu1, cpu2);
+    concurrent::benchmark::queue::MeasureFanIn<16>(iterations, cpu1, cpu2);
+    concurrent::benchmark::queue::MeasureFanIn<64>(iterations, cpu1, cpu2);
+    concurrent::benchmark::queue::MeasureFanIn<256>(iterations, cpu1, cpu2);
+
+    return 0;
+}
@@ -0,0 +1,200 @@
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+#include "benchmark_utils.h"
+
+#include "bounded_sp_sc_queue.h"
+#include "batched_bounded_sp_sc_queue.h"
+#include "bounded_mp_mc_queue.h"
+#include "bounded_multicast_queue.h"
+#include "seq_lock.h"
+
+namespace concurrent::benchmark::latency {
+
+    using Value = std::int64_t;
+
+    inline constexpr std::size_t kQueueCapacity = 1024;
+
+    // Channels adapt the data structures to the same blocking Send/Receive interface.
+    // Every channel has one sender thread and one receiver thread
+    class SPSCQueueChannel {
+    public:
+        void Send(Value value) {
+            while (!queue_.Enqueue(value));
+        }
+
+        Value Receive() {
+            Value value = 0;
+            while (!queue_.Dequeue(value));
+            return value;
+        }
+
+    private:
+        concurrent::queue::BoundedSPSCQueue<Value, kQueueCapacity> queue_{};
+    };
+
+    // Every value is flushed, so it measures the latency of the batch with one element
+    class BatchedSPSCQueueChannel {
+    public:
+        void Send(Value value) {
+            while (!queue_.Enqueue(value));
+            queue_.Flush();
+        }
+
+        Value Receive() {
+            Value* front = nullptr;
+            while (!(front = queue_.Front()));
+            const Value value = *front;
+            queue_.Dequeue();
+            return value;
+        }
+
+    private:
+        concurrent::queue::BatchedBoundedSPSCQueue<Value, kQueueCapacity> queue_{};
+    };
+
+    class MPMCQueueChannel {
+    public:
+        void Send(Value value) {
+            queue_.Enqueue(value);
+        }
+
+        Value Receive() {
+            Value value = 0;
+            queue_.Dequeue(value);
+            return value;
+        }
+
+    private:
+        concurrent::queue::BoundedMPMCQueue<Value, kQueueCapacity> queue_{};
+    };
+
+    class MulticastQueueChannel {
+    private:
+        using Queue = concurrent::queue::BoundedMulticastQueue<kQueueCapacity, sizeof(Value), alignof(Value)>;
+
+    public:
+        void Send(Value value) {
+            writer_.Write(value);
+        }
+
+        Value Receive() {
+            Value value = 0;
+            reader_.Read(value);
+            return value;
+        }
+
+    private:
+        Queue queue_{};
+        Queue::Writer writer_{&queue_};
+        Queue::Reader reader_{&queue_};
+    };
+
+    // The sent values must be unique, so the receiver can see that the value was updated
+    class SeqLockAtomicChannel {
+    public:
+        void Send(Value value) {
+            atomic_.Store(value);
+        }
+
+        Value Receive() {
+            Value value = last_value_;
+            while ((value = atomic_.Load()) == last_value_);
+            last_value_ = value;
+            return value;
+        }
+
+    private:
+        concurrent::lock::SeqLockAtomic<Value> atomic_{-1};
+        Value last_value_{-1};
+    };
+
+
+    // The sender sends the index, the receiver returns it back through the second channel
+    template<typename Channel>
+    void MeasureRoundTripLatency(const std::string& name, const TscClock& clock, const IterationsCount iterations,
+                                 int sender_cpu, int receiver_cpu) {
+        Channel ping, pong;
+        LatencyHistogram histogram;
+
+        auto t = std::thread([&ping, &pong, iterations, receiver_cpu] {
+            concurrent::benchmark::PinThread(receiver_cpu);
+            for (IterationsCount i = 0; i < iterations; ++i) {
+                pong.Send(ping.Receive());
+            }
+        });
+
+        concurrent::benchmark::PinThread(sender_cpu);
+
+        for (IterationsCount i = 0; i < iterations; ++i) {
+            const auto start = clock.Now();
+            ping.Send(i);
+            pong.Receive();
+            histogram.Record(clock.ToNanoseconds(clock.Now() - start));
+        }
+        t.join();
+
+        std::cout << "RTT latency of the " << name << ":" << std::endl;
+        concurrent::benchmark::PrintPercentiles(histogram);
+    }
+
+    // The sender sends the current time, the receiver records the difference.
+    // The next value is sent only after the previous one was received, so the values do not wait in the queue.
+    // The difference is negative, when the counter of the receiver is behind, and is recorded as 0
+    template<typename Channel>
+    void MeasureOneWayLatency(const std::string& name, const TscClock& clock, const IterationsCount iterations,
+                              int sender_cpu, int receiver_cpu) {
+        Channel channel;
+        LatencyHistogram histogram;
+        std::atomic<IterationsCount> received_count{0};
+
+        auto t = std::thread([&channel, &histogram, &received_count, &clock, iterations, receiver_cpu] {
+            concurrent::benchmark::PinThread(receiver_cpu);
+            for (IterationsCount i = 0; i < iterations; ++i) {
+                const auto sent_time = static_cast<TscClock::Ticks>(channel.Receive());
+                histogram.Record(clock.ToNanoseconds(static_cast<std::int64_t>(clock.Now() - sent_time)));
+                received_count.store(i + 1, std::memory_order_release);
+            }
+        });
+
+        concurrent::benchmark::PinThread(sender_cpu);
+
+        for (IterationsCount i = 0; i < iterations; ++i) {
+            while (received_count.load(std::memory_order_acquire) != i);
+            channel.Send(static_cast<Value>(clock.Now()));
+        }
+        t.join();
+
+        std::cout << "One-way latency of the " << name << ":" << std::endl;
+        concurrent::benchmark::PrintPercentiles(histogram);
+    }
+
+    template<typename Channel>
+    void MeasureLatency(const std::string& name, const TscClock& clock, const IterationsCount iterations,
+                        int sender_cpu, int receiver_cpu) {
+        MeasureRoundTripLatency<Channel>(name, clock, iterations, sender_cpu, receiver_cpu);
+        MeasureOneWayLatency<Channel>(name, clock, iterations, sender_cpu, receiver_cpu);
+    }
+
+} // End of namespace concurrent::benchmark::latency
+
+int main() {
+    using namespace concurrent::benchmark::latency;
+
+    int cpu1 = 0;
+    int cpu2 = 1;
+
+    const concurrent::benchmark::IterationsCount iterations = 100000;
+    const concurrent::benchmark::TscClock clock;
+
+    MeasureLatency<SPSCQueueChannel>("concurrent::queue::BoundedSPSCQueue", clock, iterations, cpu1, cpu2);
+    MeasureLatency<BatchedSPSCQueueChannel>("concurrent::queue::BatchedBoundedSPSCQueue", clock, iterations, cpu1, cpu2);
+    MeasureLatency<MPMCQueueChannel>("concurrent::queue::BoundedMPMCQueue", clock, iterations, cpu1, cpu2);
+    MeasureLatency<MulticastQueueChannel>("concurrent::queue::BoundedMulticastQueue", clock, iterations, cpu1, cpu2);
+    MeasureLatency<SeqLockAtomicChannel>("concurrent::lock::SeqLockAtomic", clock, iterations, cpu1, cpu2);
+
+    return 0;
+}
@@ -1,32 +1,418 @@
+#include <iostream>
 #include <vector>
 #include <thread>
+#include <atomic>
+#include <numeric>
+#include <bit>
+#include <string>
+#include <cstdint>
+
+#include "benchmark_utils.h"
 
 #include "bounded_mp_mc_queue.h"
+#include "unbounded_mp_mc_queue.h"
+#include "bounded_mp_sc_queue.h"
+#include "intrusive_mp_sc_queue.h"
+#include "sharded_mp_mc_queue.h"
+
+namespace concurrent::benchmark::queue {
+
+    using concurrent::queue::MPMCQueueSlotLayout;
+
+    inline constexpr std::size_t kQueueCapacity = 4096;
+    inline constexpr std::size_t kLargeQueueCapacity = 1 << 20;
+
+    template<std::size_t Capacity, MPMCQueueSlotLayout Layout, typename Element = int>
+    using Queue = concurrent::queue::BoundedMPMCQueue<Element, Capacity, std::allocator<Element>, concurrent::wait::BusySpinWaitStrategy, Layout>;
+
+    const char* GetLayoutName(MPMCQueueSlotLayout layout) {
+        return layout == MPMCQueueSlotLayout::kPadded ? "padded" : "packed";
+    }
+
+    // Every producer enqueues the batches of batch_size elements, every consumer dequeues the batches of the same size.
+    // The batch of size 1 is enqueued with Emplace and dequeued with Dequeue.
+    // The elements of 4 bytes are stored in one word with the generation of the slot
+    template<std::size_t Capacity = kQueueCapacity, MPMCQueueSlotLayout Layout = MPMCQueueSlotLayout::kPadded, typename Element = int>
+    void MeasureThroughput(const std::size_t threads_count, const std::size_t batch_size, const IterationsCount iterations) {
+        Queue<Capacity, Layout, Element> q{};
+
+        const IterationsCount batches_count = iterations / static_cast<IterationsCount>(batch_size);
+
+        std::vector<std::thread> consumers;
+        std::vector<std::thread> producers;
+
+        auto start = std::chrono::steady_clock::now(); // Start measure the time
+
+        for (std::size_t t = 0; t < threads_count; t++) {
+            consumers.emplace_back([&q, batch_size, batches_count]() {
+                std::vector<Element> batch(batch_size);
+                for (IterationsCount i = 0; i < batches_count; i++) {
+                    if (batch_size == 1) {
+                        q.Dequeue(batch[0]);
+                    } else {
+                        q.DequeueBulk(batch.begin(), batch_size);
+                    }
+                }
+            });
+
+            producers.emplace_back([&q, batch_size, batches_count]() {
+                std::vector<Element> batch(batch_size);
+                std::iota(batch.begin(), batch.end(), 0);
+                for (IterationsCount i = 0; i < batches_count; i++) {
+                    if (batch_size == 1) {
+                        q.Emplace(batch[0]);
+                    } else {
+                        q.EnqueueBulk(batch.begin(), batch.end());
+                    }
+                }
+            });
+        }
+
+        for (std::size_t t = 0; t < threads_count; t++) {
+            producers[t].join();
+            consumers[t].join();
+        }
+
+        auto stop = std::chrono::steady_clock::now(); // Stop measure the time
+
+        const IterationsCount total_count = batches_count * static_cast<IterationsCount>(batch_size * threads_count);
+        std::cout << "Throughput of the concurrent::queue::BoundedMPMCQueue (" << GetLayoutName(Layout) << " slots, capacity "
+                  << q.GetCapacity() << ", " << sizeof(Element) << "-byte elements) with " << threads_count << " producers, " << threads_count
+                  << " consumers and batch size " << batch_size << ":" << std::endl;
+        std::cout << concurrent::benchmark::GetThroughput(total_count, start, stop) << " ops/ms" << std::endl;
+    }
+
+    // The memory used by the slots of the queue with one million elements, and its throughput.
+    // The queue does not fit in the cache with the padded slots
+    template<MPMCQueueSlotLayout Layout>
+    void MeasureSlotLayout(const IterationsCount iterations) {
+        using Slot = concurrent::queue::details::MPMCQueueSlotFor<int, Layout>;
+
+        std::cout << "Memory footprint of the concurrent::queue::BoundedMPMCQueue with " << GetLayoutName(Layout) << " slots: "
+                  << sizeof(Slot) * std::bit_ceil(kLargeQueueCapacity + 1) / (1 << 20) << " MB" << std::endl;
+
+        for (std::size_t threads_count = 1; threads_count <= 8; threads_count *= 2) {
+            MeasureThroughput<kLargeQueueCapacity, Layout>(threads_count, 1, iterations);
+        }
+    }
+
+    // The same scenario as MeasureThroughput with the batch of size 1. Unlike the bounded queue, the producers
+    // are not held up by the consumers, so the throughput includes the allocation of the new segments
+    void MeasureUnboundedThroughput(const std::size_t threads_count, const IterationsCount iterations) {
+        concurrent::queue::UnboundedMPMCQueue<int> q;
+
+        std::vector<std::thread> consumers;
+        std::vector<std::thread> producers;
+
+        auto start = std::chrono::steady_clock::now(); // Start measure the time
+
+        for (std::size_t t = 0; t < threads_count; t++) {
+            consumers.emplace_back([&q, iterations]() {
+                int element;
+                for (IterationsCount i = 0; i < iterations; i++) {
+                    q.Dequeue(element);
+                }
+            });
+
+            producers.emplace_back([&q, iterations]() {
+                for (IterationsCount i = 0; i < iterations; i++) {
+                    q.Emplace(static_cast<int>(i));
+                }
+            });
+        }
+
+        for (std::size_t t = 0; t < threads_count; t++) {
+            producers[t].join();
+            consumers[t].join();
+        }
+
+        auto stop = std::chrono::steady_clock::now(); // Stop measure the time
+
+        std::cout << "Throughput of the concurrent::queue::UnboundedMPMCQueue (segment capacity " << q.GetSegmentCapacity()
+                  << ") with " << threads_count << " producers and " << threads_count << " consumers:" << std::endl;
+        std::cout << concurrent::benchmark::GetThroughput(iterations * static_cast<IterationsCount>(threads_count), start, stop)
+                  << " ops/ms" << std::endl;
+    }
+
+    // producers_count producers and one consumer. The iterations are split between the producers,
+    // so the consumer, which is the bottleneck, dequeues the same number of elements for every producers_count
+    template<typename Queue>
+    void MeasureManyToOneThroughput(const std::string& name, const std::size_t producers_count, const IterationsCount iterations) {
+        Queue q{kQueueCapacity};
+
+        const IterationsCount producer_iterations = iterations / static_cast<IterationsCount>(producers_count);
+
+        std::vector<std::thread> producers;
+
+        auto start = std::chrono::steady_clock::now(); // Start measure the time
+
+        for (std::size_t t = 0; t < producers_count; t++) {
+            producers.emplace_back([&q, producer_iterations]() {
+                for (IterationsCount i = 0; i < producer_iterations; i++) {
+                    q.Emplace(static_cast<int>(i));
+                }
+            });
+        }
+
+        int element;
+        for (IterationsCount i = 0; i < producer_iterations * static_cast<IterationsCount>(producers_count); i++) {
+            q.Dequeue(element);
+        }
+
+        for (auto& producer : producers) {
+            producer.join();
+        }
+
+        auto stop = std::chrono::steady_clock::now(); // Stop measure the time
+
+        std::cout << "Throughput of the " << name << " with " << producers_count << " producers and 1 consumer:" << std::endl;
+        std::cout << concurrent::benchmark::GetThroughput(producer_iterations * static_cast<IterationsCount>(producers_count), start, stop)
+                  << " ops/ms" << std::endl;
+    }
+
+    struct Message : concurrent::queue::IntrusiveMPSCQueueNode {
+        int value{0};
+    };
+
+    // The same scenario for the intrusive queue. The messages are allocated before the measurement,
+    // as they are embedded in the objects of the application
+    void MeasureIntrusiveManyToOneThroughput(const std::size_t producers_count, const IterationsCount iterations) {
+        concurrent::queue::IntrusiveMPSCQueue<Message> q;
+
+        const IterationsCount producer_iterations = iterations / static_cast<IterationsCount>(producers_count);
+        std::vector<std::vector<Message>> messages(producers_count, std::vector<Message>(producer_iterations));
+
+        std::vector<std::thread> producers;
+
+        auto start = std::chrono::steady_clock::now(); // Start measure the time
+
+        for (std::size_t t = 0; t < producers_count; t++) {
+            producers.emplace_back([&q, &producer_messages = messages[t]]() {
+                for (Message& message : producer_messages) {
+                    q.Enqueue(&message);
+                }
+            });
+        }
+
+        for (IterationsCount i = 0; i < producer_iterations * static_cast<IterationsCount>(producers_count); i++) {
+            q.Dequeue();
+        }
+
+        for (auto& producer : producers) {
+            producer.join();
+        }
+
+        auto stop = std::chrono::steady_clock::now(); // Stop measure the time
+
+        std::cout << "Throughput of the concurrent::queue::IntrusiveMPSCQueue with " << producers_count << " producers and 1 consumer:" << std::endl;
+        std::cout << concurrent::benchmark::GetThroughput(producer_iterations * static_cast<IterationsCount>(producers_count), start, stop)
+                  << " ops/ms" << std::endl;
+    }
+
+    // threads_count / 2 producers and threads_count / 2 consumers. Every thread enqueues (dequeues) the same number
+    // of elements, so the total throughput shows how the queue scales with the number of threads
+    template<typename Queue>
+    void MeasureScalability(const std::string& name, Queue& q, const std::size_t threads_count, const IterationsCount iterations) {
+        const std::size_t pairs_count = threads_count / 2;
+
+        std::vector<std::thread> consumers;
+        std::vector<std::thread> producers;
+
+        auto start = std::chrono::steady_clock::now(); // Start measure the time
+
+        for (std::size_t t = 0; t < pairs_count; t++) {
+            consumers.emplace_back([&q, iterations]() {
+                int element;
+                for (IterationsCount i = 0; i < iterations; i++) {
+                    q.Dequeue(element);
+                }
+            });
+
+            producers.emplace_back([&q, iterations]() {
+                for (IterationsCount i = 0; i < iterations; i++) {
+                    q.Emplace(static_cast<int>(i));
+                }
+            });
+        }
+
+        for (std::size_t t = 0; t < pairs_count; t++) {
+            producers[t].join();
+            consumers[t].join();
+        }
+
+        auto stop = std::chrono::steady_clock::now(); // Stop measure the time
+
+        std::cout << "Throughput of the " << name << " with " << threads_count << " threads:" << std::endl;
+        std::cout << concurrent::benchmark::GetThroughput(iterations * static_cast<IterationsCount>(pairs_count), start, stop)
+                  << " ops/ms" << std::endl;
+    }
+
+    // MeasureScalability for the ShardedMPMCQueue. The producer and the consumer of every pair pass the same home shard,
+    // so the pairs work on their own shards and the consumers steal only when their shard is empty
+    template<typename Queue>
+    void MeasureShardedScalability(const std::string& name, Queue& q, const std::size_t threads_count, const IterationsCount iterations) {
+        const std::size_t pairs_count = threads_count / 2;
+
+        std::vector<std::thread> consumers;
+        std::vector<std::thread> producers;
+
+        auto start = std::chrono::steady_clock::now(); // Start measure the time
+
+        for (std::size_t t = 0; t < pairs_count; t++) {
+            consumers.emplace_back([&q, t, iterations]() {
+                typename Queue::Token token{&q, t};
+                int element;
+                for (IterationsCount i = 0; i < iterations; i++) {
+                    token.Dequeue(element);
+                }
+            });
+
+            producers.emplace_back([&q, t, iterations]() {
+                typename Queue::Token token{&q, t};
+                for (IterationsCount i = 0; i < iterations; i++) {
+                    token.Emplace(static_cast<int>(i));
+                }
+            });
+        }
+
+        for (std::size_t t = 0; t < pairs_count; t++) {
+            producers[t].join();
+            consumers[t].join();
+        }
+
+        auto stop = std::chrono::steady_clock::now(); // Stop measure the time
+
+        std::cout << "Throughput of the " << name << " with " << threads_count << " threads:" << std::endl;
+        std::cout << concurrent::benchmark::GetThroughput(iterations * static_cast<IterationsCount>(pairs_count), start, stop)
+                  << " ops/ms" << std::endl;
+    }
+
+    // threads_count producers and threads_count consumers. With block_size greater than 0 every producer (consumer)
+    // uses the ProducerToken (ConsumerToken), which claims block_size positions with one atomic RMW operation
+    void MeasureTokensThroughput(const std::size_t threads_count, const std::size_t block_size, const IterationsCount iterations) {
+        using TokenQueue = concurrent::queue::BoundedMPMCQueue<int>;
+        TokenQueue q{kQueueCapacity};
+
+        const IterationsCount total_count = iterations * static_cast<IterationsCount>(threads_count);
+        std::atomic<IterationsCount> consumed_count{0};
+
+        std::vector<std::thread> consumers;
+        std::vector<std::thread> producers;
+
+        auto start = std::chrono::steady_clock::now(); // Start measure the time
+
+        for (std::size_t t = 0; t < threads_count; t++) {
+            consumers.emplace_back([&q, &consumed_count, total_count, block_size, iterations]() {
+                int element;
+                if (block_size) {
+                    // The token holds the claimed elements, so the consumers stop only when all elements are dequeued.
+                    // The dequeued elements are counted once per block
+                    TokenQueue::ConsumerToken token{&q, block_size};
+                    IterationsCount pending_count = 0;
+                    while (consumed_count.load(std::memory_order_relaxed) < total_count) {
+                        if (token.TryDequeue(element)) {
+                            ++pending_count;
+                        } else {
+                            std::this_thread::yield(); // The consumers, which are left without the elements, must not hold up the producers
+                        }
+                        if (pending_count && token.IsDrained()) {
+                            consumed_count.fetch_add(pending_count, std::memory_order_relaxed);
+                            pending_count = 0;
+                        }
+                    }
+                } else {
+                    for (IterationsCount i = 0; i < iterations; i++) {
+                        q.Dequeue(element);
+                    }
+                }
+            });
+
+            producers.emplace_back([&q, block_size, iterations]() {
+                if (block_size) {
+                    TokenQueue::ProducerToken token{&q, block_size};
+                    for (IterationsCount i = 0; i < iterations; i++) {
+                        token.Emplace(static_cast<int>(i));
+                    }
+                } else {
+                    for (IterationsCount i = 0; i < iterations; i++) {
+                        q.Emplace(static_cast<int>(i));
+                    }
+                }
+            });
+        }
+
+        for (std::size_t t = 0; t < threads_count; t++) {
+            producers[t].join();
+            consumers[t].join();
+        }
+
+        auto stop = std::chrono::steady_clock::now(); // Stop measure the time
+
+        std::cout << "Throughput of the concurrent::queue::BoundedMPMCQueue with " << threads_count << " producers, "
+                  << threads_count << " consumers and ";
+        if (block_size) {
+            std::cout << "tokens of block size " << block_size << ":" << std::endl;
+        } else {
+            std::cout << "no tokens:" << std::endl;
+        }
+        std::cout << concurrent::benchmark::GetThroughput(iterations * static_cast<IterationsCount>(threads_count), start, stop)
+                  << " ops/ms" << std::endl;
+    }
+
+} // End of namespace concurrent::benchmark::queue
 
 int main() {
-    std::vector<std::thread> consumers;
-    std::vector<std::thread> producers;
-
-    const std::size_t capacity = 400;
-    concurrent::queue::BoundedMPMCQueue<int, capacity> q;
-    for (int t = 0; t < 3; t++) {
-        consumers.emplace_back([&q]() {
-            int result = 0;
-            for (int i = 0; i < 100; i++) {
-                q.Dequeue(result);
-            }
-        });
-
-        producers.emplace_back([&q]() {
-            for (int i = 0; i < 100; i++) {
-                q.Emplace(i);
-            }
-        });
-    }
-
-    for (int t = 0; t < 3; t++) {
-        producers[t].join();
-        consumers[t].join();
+    const concurrent::benchmark::IterationsCount iterations = 1 << 20; // Per producer
+
+    for (std::size_t threads_count = 1; threads_count <= 8; threads_count *= 2) {
+        for (std::size_t batch_size = 1; batch_size <= 64; batch_size *= 4) {
+            concurrent::benchmark::queue::MeasureThroughput(threads_count, batch_size, iterations);
+        }
     }
+
+    for (std::size_t threads_count = 1; threads_count <= 8; threads_count *= 2) {
+        concurrent::benchmark::queue::MeasureThroughput(threads_count, 1, iterations);
+        concurrent::benchmark::queue::MeasureUnboundedThroughput(threads_count, iterations);
+    }
+
+    using ManyToOneMPMCQueue = concurrent::queue::BoundedMPMCQueue<int>;
+    using ManyToOneMPSCQueue = concurrent::queue::BoundedMPSCQueue<int>;
+    for (std::size_t producers_count = 1; producers_count <= 8; producers_count *= 2) {
+        concurrent::benchmark::queue::MeasureManyToOneThroughput<ManyToOneMPMCQueue>("concurrent::queue::BoundedMPMCQueue", producers_count, iterations);
+        concurrent::benchmark::queue::MeasureManyToOneThroughput<ManyToOneMPSCQueue>("concurrent::queue::BoundedMPSCQueue", producers_count, iterations);
+        concurrent::benchmark::queue::MeasureIntrusiveManyToOneThroughput(producers_count, iterations);
+    }
+
+    for (std::size_t threads_count = 2; threads_count <= 64; threads_count *= 2) {
+        const std::size_t capacity = concurrent::benchmark::queue::kQueueCapacity;
+
+        concurrent::queue::BoundedMPMCQueue<int> mp_mc_queue{capacity};
+        concurrent::benchmark::queue::MeasureScalability("concurrent::queue::BoundedMPMCQueue", mp_mc_queue, threads_count, iterations);
+
+        // One shard per producer and consumer pair, the total capacity is the same
+        const std::size_t shards_count = std::max<std::size_t>(threads_count / 2, 1);
+        concurrent::queue::ShardedMPMCQueue<int> sharded_queue{capacity / shards_count, shards_count};
+        concurrent::benchmark::queue::MeasureShardedScalability("concurrent::queue::ShardedMPMCQueue", sharded_queue, threads_count, iterations);
+    }
+
+    for (std::size_t threads_count = 8; threads_count <= 16; threads_count *= 2) {
+        for (std::size_t block_size = 0; block_size <= 64; block_size = block_size ? block_size * 4 : 4) {
+            concurrent::benchmark::queue::MeasureTokensThroughput(threads_count, block_size, iterations);
+        }
+    }
+
+    // The word slots of the 4-byte elements against the slots with the separate generation
+    for (std::size_t threads_count = 1; threads_count <= 8; threads_count *= 2) {
+        using concurrent::queue::MPMCQueueSlotLayout;
+        using concurrent::benchmark::queue::kQueueCapacity;
+        concurrent::benchmark::queue::MeasureThroughput<kQueueCapacity, MPMCQueueSlotLayout::kPadded, std::uint32_t>(threads_count, 1, iterations);
+        concurrent::benchmark::queue::MeasureThroughput<kQueueCapacity, MPMCQueueSlotLayout::kPadded, std::uint64_t>(threads_count, 1, iterations);
+        concurrent::benchmark::queue::MeasureThroughput<kQueueCapacity, MPMCQueueSlotLayout::kPacked, std::uint32_t>(threads_count, 1, iterations);
+        concurrent::benchmark::queue::MeasureThroughput<kQueueCapacity, MPMCQueueSlotLayout::kPacked, std::uint64_t>(threads_count, 1, iterations);
+    }
+
+    concurrent::benchmark::queue::MeasureSlotLayout<concurrent::queue::MPMCQueueSlotLayout::kPadded>(iterations);
+    concurrent::benchmark::queue::MeasureSlotLayout<concurrent::queue::MPMCQueueSlotLayout::kPacked>(iterations);
+
     return 0;
 }
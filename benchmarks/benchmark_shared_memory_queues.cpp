@@ -0,0 +1,103 @@
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "benchmark_utils.h"
+
+#include "shared_memory_sp_sc_queue.h"
+
+namespace concurrent::benchmark::queue {
+
+    using Queue = concurrent::queue::SharedMemorySPSCQueue<int>;
+
+    // Runs the function in the child process and returns its pid.
+    // The child exits with std::_Exit, so the destructors of the copied parent queues don't remove the shared memory
+    template<typename Function>
+    pid_t Fork(Function&& function) {
+        const pid_t pid = fork();
+        if (pid == -1) {
+            std::cerr << "Failed during fork" << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+        if (!pid) {
+            function();
+            std::_Exit(EXIT_SUCCESS);
+        }
+        return pid;
+    }
+
+    void MeasureThroughput(const IterationsCount iterations, const std::size_t capacity, int producer_cpu, int consumer_cpu) {
+        const std::string name = "/concurrent_benchmark_throughput_" + std::to_string(getpid());
+        Queue q{name, capacity};
+
+        const pid_t consumer = Fork([&name, iterations, consumer_cpu] {
+            concurrent::benchmark::PinThread(consumer_cpu);
+            Queue q{name};
+            int result = 0;
+            for (IterationsCount i = 0; i < iterations; ++i) {
+                while (!q.Dequeue(result));
+            }
+        });
+
+        concurrent::benchmark::PinThread(producer_cpu);
+
+        auto start = std::chrono::steady_clock::now(); // Start measure the time
+
+        for (IterationsCount i = 0; i < iterations; ++i) {
+            while (!q.Enqueue(static_cast<int>(i)));
+        }
+        waitpid(consumer, nullptr, 0);
+
+        auto stop = std::chrono::steady_clock::now(); // Stop measure the time
+
+        std::cout << "Throughput of the concurrent::queue::SharedMemorySPSCQueue between 2 processes:" << std::endl;
+        std::cout << concurrent::benchmark::GetThroughput(iterations, start, stop) << " ops/ms" << std::endl;
+    }
+
+    void MeasureLatency(const IterationsCount iterations, const std::size_t capacity, int producer_cpu, int consumer_cpu) {
+        const std::string name = "/concurrent_benchmark_latency_" + std::to_string(getpid());
+        Queue q1{name + "_1", capacity}, q2{name + "_2", capacity};
+
+        const pid_t consumer = Fork([&name, iterations, consumer_cpu] {
+            concurrent::benchmark::PinThread(consumer_cpu);
+            Queue q1{name + "_1"}, q2{name + "_2"};
+            int result = 0;
+            for (IterationsCount i = 0; i < iterations; ++i) {
+                while (!q1.Dequeue(result));
+                while (!q2.Enqueue(result));
+            }
+        });
+
+        concurrent::benchmark::PinThread(producer_cpu);
+
+        auto start = std::chrono::steady_clock::now(); // Start measure the time
+
+        int result = 0;
+        for (IterationsCount i = 0; i < iterations; ++i) {
+            while (!q1.Enqueue(static_cast<int>(i)));
+            while (!q2.Dequeue(result));
+        }
+        waitpid(consumer, nullptr, 0);
+
+        auto stop = std::chrono::steady_clock::now(); // Stop measure the time
+
+        std::cout << "Latency of the concurrent::queue::SharedMemorySPSCQueue between 2 processes:" << std::endl;
+        std::cout << concurrent::benchmark::GetLatency(iterations, start, stop) << " ns RTT" << std::endl;
+    }
+
+} // End of namespace concurrent::benchmark::queue
+
+int main() {
+    int cpu1 = 0;
+    int cpu2 = 1;
+
+    const std::size_t capacity = 100000;
+    const concurrent::benchmark::IterationsCount iterations = 100000;
+
+    concurrent::benchmark::queue::MeasureThroughput(iterations, capacity, cpu1, cpu2);
+    concurrent::benchmark::queue::MeasureLatency(iterations, capacity, cpu1, cpu2);
+
+    return 0;
+}
@@ -3,48 +3,14 @@
 #include <type_traits>
 #include <vector>
 #include <array>
+#include <atomic>
+#include <algorithm>
 
 #include "benchmark_utils.h"
 #include "utils.h"
-#include "bounded_sp_sc_queue.h"
+#include "fan_out_queue.h"
 #include "bounded_multicast_queue.h"
 
-namespace concurrent::queue {
-
-    template<typename T,
-            std::size_t MessagesCount,
-            std::size_t ConsumersCount,
-            typename SPSCQueue = concurrent::queue::BoundedSPSCQueue<T, MessagesCount>>
-    class SPSCBasedSPMCQueue {
-    public:
-        SPSCBasedSPMCQueue() = default;
-
-        SPSCBasedSPMCQueue(const SPSCBasedSPMCQueue&) = delete;
-        SPSCBasedSPMCQueue(SPSCBasedSPMCQueue&&) = delete;
-        SPSCBasedSPMCQueue& operator=(const SPSCBasedSPMCQueue&) = delete;
-        SPSCBasedSPMCQueue& operator=(SPSCBasedSPMCQueue&&) = delete;
-
-        bool Read(std::size_t consumer, T& message);
-        bool Write(std::size_t consumer, T desired_message);
-
-        ~SPSCBasedSPMCQueue() = default;
-
-    private:
-        std::array<SPSCQueue, ConsumersCount> queues{};
-    };
-
-    template<typename T, std::size_t MessagesCount, std::size_t ConsumersCount, typename SPSCQueue>
-    bool SPSCBasedSPMCQueue<T, MessagesCount, ConsumersCount, SPSCQueue>::Read(std::size_t consumer, T& message) {
-        return queues[consumer].Dequeue(message);
-    }
-
-    template<typename T, std::size_t MessagesCount, std::size_t ConsumersCount, typename SPSCQueue>
-    bool SPSCBasedSPMCQueue<T, MessagesCount, ConsumersCount, SPSCQueue>::Write(std::size_t consumer, T desired_message) {
-        return queues[consumer].Enqueue(std::move(desired_message));
-    }
-
-}
-
 namespace concurrent::benchmark::queue {
 
     struct Message {
@@ -115,7 +81,7 @@ namespace concurrent::benchmark::queue {
         {
             std::vector<std::thread> readers;
 
-            using Queue = concurrent::queue::SPSCBasedSPMCQueue<Message, Capacity, ReadersCount>;
+            using Queue = concurrent::queue::FanOutQueue<Message, ReadersCount, Capacity>;
 
             Queue q{};
 
@@ -139,10 +105,8 @@ namespace concurrent::benchmark::queue {
             concurrent::benchmark::PinThread(cpu[ReadersCount]);
             Message message{};
             for (int i = 0; i < rounds_count * capacity; i++) {
-                for (size_t r = 0; r < ReadersCount; r++) {
-                    message.x_ = i;
-                    while (!q.Write(r, message));
-                }
+                message.x_ = i;
+                q.Write(message);
             }
 
             for (int r = 0; r < ReadersCount; r++) {
@@ -151,11 +115,69 @@ namespace concurrent::benchmark::queue {
 
             auto stop = std::chrono::steady_clock::now(); // Stop measure the time
 
-            std::cout << "Throughput of the concurrent::queue::SPSCBasedSPMCQueue: " << std::endl;
+            std::cout << "Throughput of the concurrent::queue::FanOutQueue: " << std::endl;
             std::cout << concurrent::benchmark::GetThroughput(capacity * rounds_count, start, stop) << " ops/ms" << std::endl;
         }
     }
 
+    // The last reader is slow, so the producer drops the messages for it.
+    // The lag of the readers is sampled by producer and shows which reader holds it up
+    template<std::size_t ReadersCount, std::size_t Capacity>
+    void MeasureSlowReader(const size_t rounds_count, std::array<int, ReadersCount + 1> cpu) {
+        using namespace std::chrono_literals;
+        using Queue = concurrent::queue::FanOutQueue<Message, ReadersCount, Capacity, concurrent::queue::SlowConsumerPolicy::kDrop>;
+
+        const std::size_t messages_count = rounds_count * Capacity;
+
+        Queue q{};
+        std::atomic<bool> is_stopped{false};
+        std::vector<std::thread> readers;
+
+        for (std::size_t r = 0; r < ReadersCount; r++) {
+            int cpu_number = cpu[r];
+            readers.emplace_back([&q, &is_stopped, cpu_number, r]() {
+                concurrent::benchmark::PinThread(cpu_number);
+
+                Message result{};
+                while (!is_stopped.load(std::memory_order_acquire) || q.GetLag(r)) {
+                    if (q.Read(r, result) && r + 1 == ReadersCount) {
+                        std::this_thread::sleep_for(1us);
+                    }
+                }
+            });
+        }
+
+        concurrent::benchmark::PinThread(cpu[ReadersCount]);
+
+        std::array<std::size_t, ReadersCount> max_lag{};
+
+        auto start = std::chrono::steady_clock::now(); // Start measure the time
+
+        Message message{};
+        for (std::size_t i = 0; i < messages_count; i++) {
+            message.x_ = static_cast<int>(i);
+            q.Write(message);
+            if (i % Capacity == 0) {
+                for (std::size_t r = 0; r < ReadersCount; r++) {
+                    max_lag[r] = std::max(max_lag[r], q.GetLag(r));
+                }
+            }
+        }
+
+        auto stop = std::chrono::steady_clock::now(); // Stop measure the time
+
+        is_stopped.store(true, std::memory_order_release);
+        for (auto& reader : readers) {
+            reader.join();
+        }
+
+        std::cout << "Throughput of the concurrent::queue::FanOutQueue with the slow reader: " << std::endl;
+        std::cout << concurrent::benchmark::GetThroughput(messages_count, start, stop) << " ops/ms" << std::endl;
+        for (std::size_t r = 0; r < ReadersCount; r++) {
+            std::cout << "Reader " << r << ": max lag " << max_lag[r] << ", dropped " << q.GetDroppedCount(r) << std::endl;
+        }
+    }
+
 }
 
 int main() {
@@ -166,5 +188,6 @@ int main() {
     const size_t capacity = 10000;
 
     concurrent::benchmark::queue::MeasureThroughput<readers_count, capacity>(rounds_count, cpu);
+    concurrent::benchmark::queue::MeasureSlowReader<readers_count, capacity>(rounds_count, cpu);
     return 0;
 }
\ No newline at end of file
@@ -1,6 +1,13 @@
 #include <iostream>
 #include <thread>
 #include <cassert>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <random>
+#include <cstring>
+#include <cstdint>
+#include <string>
 #include <boost/lockfree/spsc_queue.hpp>
 //#include <folly/ProducerConsumerQueue.h>
 
@@ -8,6 +15,312 @@
 
 #include "batched_bounded_sp_sc_queue.h"
 #include "bounded_sp_sc_queue.h"
+#include "flagged_bounded_sp_sc_queue.h"
+#include "bounded_sp_sc_byte_queue.h"
+#include "unbounded_sp_sc_queue.h"
+
+namespace concurrent::benchmark::queue {
+
+    template<std::size_t QueueSize>
+    void MeasureBulkThroughput(const IterationsCount iterations, const std::size_t bulk_size, int producer_cpu, int consumer_cpu) {
+        concurrent::queue::BoundedSPSCQueue<int, QueueSize> q{};
+
+        auto t = std::thread([&q, iterations, bulk_size, consumer_cpu] {
+            concurrent::benchmark::PinThread(consumer_cpu);
+            std::vector<int> bulk(bulk_size);
+            for (IterationsCount i = 0; i < iterations;) {
+                i += static_cast<IterationsCount>(q.DequeueBulk(bulk.begin(), bulk_size));
+            }
+        });
+
+        concurrent::benchmark::PinThread(producer_cpu);
+        std::vector<int> bulk(bulk_size);
+        std::iota(bulk.begin(), bulk.end(), 0);
+
+        auto start = std::chrono::steady_clock::now(); // Start measure the time
+
+        for (IterationsCount i = 0; i < iterations; i += static_cast<IterationsCount>(bulk_size)) {
+            auto first = bulk.begin();
+            auto last = first + std::min<IterationsCount>(static_cast<IterationsCount>(bulk_size), iterations - i);
+            while (first != last) {
+                first += static_cast<std::ptrdiff_t>(q.EnqueueBulk(first, last));
+            }
+        }
+
+        t.join();
+
+        auto stop = std::chrono::steady_clock::now(); // Stop measure the time
+
+        std::cout << "Throughput of the concurrent::queue::BoundedSPSCQueue with bulk size " << bulk_size << ":" << std::endl;
+        std::cout << concurrent::benchmark::GetThroughput(iterations, start, stop) << " ops/ms" << std::endl;
+    }
+
+    // The producer publishes the whole batches and the consumer drains them with Peek/Release,
+    // so the shared indices are updated once per batch instead of once per element
+    template<std::size_t QueueSize>
+    void MeasureBatchedThroughput(const IterationsCount iterations, int producer_cpu, int consumer_cpu) {
+        constexpr std::size_t batch_size = concurrent::queue::details::kDefaultSlotSize;
+        concurrent::queue::BatchedBoundedSPSCQueue<int, QueueSize / batch_size> q{};
+
+        auto t = std::thread([&q, iterations, consumer_cpu] {
+            concurrent::benchmark::PinThread(consumer_cpu);
+            for (IterationsCount i = 0; i < iterations;) {
+                std::span<int> batch = q.Peek();
+                if (!batch.empty()) {
+                    i += static_cast<IterationsCount>(batch.size());
+                    q.Release(batch.size());
+                }
+            }
+        });
+
+        concurrent::benchmark::PinThread(producer_cpu);
+
+        auto start = std::chrono::steady_clock::now(); // Start measure the time
+
+        for (IterationsCount i = 0; i < iterations; ++i) {
+            while (!q.Emplace(static_cast<int>(i)));
+        }
+        q.Flush();
+        t.join();
+
+        auto stop = std::chrono::steady_clock::now(); // Stop measure the time
+
+        std::cout << "Throughput of the concurrent::queue::BatchedBoundedSPSCQueue with batch size " << batch_size << ":" << std::endl;
+        std::cout << concurrent::benchmark::GetThroughput(iterations, start, stop) << " ops/ms" << std::endl;
+    }
+
+    // The consumer publishes its head every HeadPublicationPeriod elements.
+    // The period 1 is the eager publication, which is used by default
+    template<std::size_t QueueSize, std::size_t HeadPublicationPeriod>
+    void MeasureLazyHeadThroughput(const IterationsCount iterations, int producer_cpu, int consumer_cpu) {
+        concurrent::queue::BoundedSPSCQueue<int, QueueSize, std::allocator<int>,
+                concurrent::wait::BusySpinWaitStrategy, HeadPublicationPeriod> q{};
+
+        auto t = std::thread([&q, iterations, consumer_cpu] {
+            concurrent::benchmark::PinThread(consumer_cpu);
+            for (IterationsCount i = 0; i < iterations; ++i) {
+                while (!q.Dequeue());
+            }
+        });
+
+        concurrent::benchmark::PinThread(producer_cpu);
+
+        auto start = std::chrono::steady_clock::now(); // Start measure the time
+
+        for (IterationsCount i = 0; i < iterations; ++i) {
+            while (!q.Emplace(static_cast<int>(i)));
+        }
+        t.join();
+
+        auto stop = std::chrono::steady_clock::now(); // Stop measure the time
+
+        std::cout << "Throughput of the concurrent::queue::BoundedSPSCQueue with head publication period "
+                  << HeadPublicationPeriod << ":" << std::endl;
+        std::cout << concurrent::benchmark::GetThroughput(iterations, start, stop) << " ops/ms" << std::endl;
+    }
+
+    struct alignas(concurrent::cache::kCacheLineSize) CacheLineMessage {
+        std::int64_t data_[concurrent::cache::kCacheLineSize / sizeof(std::int64_t)];
+    };
+
+    // The same loop for the queues with the shared indices and with the flags in the slots
+    template<typename Queue, typename Payload>
+    void MeasurePayloadThroughput(const std::string& name, const IterationsCount iterations, int producer_cpu, int consumer_cpu) {
+        Queue q{};
+
+        auto t = std::thread([&q, iterations, consumer_cpu] {
+            concurrent::benchmark::PinThread(consumer_cpu);
+            Payload payload{};
+            for (IterationsCount i = 0; i < iterations; ++i) {
+                while (!q.Dequeue(payload));
+            }
+        });
+
+        concurrent::benchmark::PinThread(producer_cpu);
+        const Payload payload{};
+
+        auto start = std::chrono::steady_clock::now(); // Start measure the time
+
+        for (IterationsCount i = 0; i < iterations; ++i) {
+            while (!q.Enqueue(payload));
+        }
+        t.join();
+
+        auto stop = std::chrono::steady_clock::now(); // Stop measure the time
+
+        std::cout << "Throughput of the " << name << " with " << sizeof(Payload) << " bytes payload:" << std::endl;
+        std::cout << concurrent::benchmark::GetThroughput(iterations, start, stop) << " ops/ms" << std::endl;
+    }
+
+    template<std::size_t QueueSize>
+    void MeasureFlaggedQueue(const IterationsCount iterations, int producer_cpu, int consumer_cpu) {
+        using concurrent::queue::BoundedSPSCQueue;
+        using concurrent::queue::FlaggedBoundedSPSCQueue;
+
+        MeasurePayloadThroughput<BoundedSPSCQueue<int, QueueSize>, int>(
+                "concurrent::queue::BoundedSPSCQueue", iterations, producer_cpu, consumer_cpu);
+        MeasurePayloadThroughput<FlaggedBoundedSPSCQueue<int, QueueSize>, int>(
+                "concurrent::queue::FlaggedBoundedSPSCQueue", iterations, producer_cpu, consumer_cpu);
+
+        MeasurePayloadThroughput<BoundedSPSCQueue<CacheLineMessage, QueueSize>, CacheLineMessage>(
+                "concurrent::queue::BoundedSPSCQueue", iterations, producer_cpu, consumer_cpu);
+        MeasurePayloadThroughput<FlaggedBoundedSPSCQueue<CacheLineMessage, QueueSize>, CacheLineMessage>(
+                "concurrent::queue::FlaggedBoundedSPSCQueue", iterations, producer_cpu, consumer_cpu);
+    }
+
+    inline constexpr std::size_t kMinMessageSize = 16;
+    inline constexpr std::size_t kMaxMessageSize = 4096;
+
+    template<std::size_t MaxSize>
+    struct FixedSizeMessage {
+        std::size_t size_{0};
+        std::byte data_[MaxSize];
+    };
+
+    // Message sizes from kMinMessageSize to kMaxMessageSize, most of them are small
+    std::vector<std::size_t> GetMixedMessageSizes(std::size_t count) {
+        std::mt19937 generator{42};
+        std::vector<std::size_t> sizes(count);
+        for (auto& size : sizes) {
+            size = kMinMessageSize << (generator() % 9);
+            size += generator() % size;
+            size = std::min(size, kMaxMessageSize);
+        }
+        return sizes;
+    }
+
+    // Both queues use the same amount of memory for the buffer
+    template<std::size_t BufferSize>
+    void MeasureMixedSizeThroughput(const IterationsCount iterations, int producer_cpu, int consumer_cpu) {
+        const std::vector<std::size_t> sizes = GetMixedMessageSizes(iterations);
+        std::vector<std::byte> payload(kMaxMessageSize);
+
+        {
+            concurrent::queue::BoundedSPSCByteQueue<BufferSize> q{};
+
+            auto t = std::thread([&q, iterations, consumer_cpu] {
+                concurrent::benchmark::PinThread(consumer_cpu);
+                std::vector<std::byte> result(kMaxMessageSize);
+                for (IterationsCount i = 0; i < iterations; ++i) {
+                    std::span<const std::byte> message;
+                    while (!(message = q.Front()).data());
+                    std::memcpy(result.data(), message.data(), message.size());
+                    q.Dequeue();
+                }
+            });
+
+            concurrent::benchmark::PinThread(producer_cpu);
+
+            auto start = std::chrono::steady_clock::now(); // Start measure the time
+
+            for (IterationsCount i = 0; i < iterations; ++i) {
+                while (!q.Enqueue(std::span<const std::byte>(payload.data(), sizes[i])));
+            }
+
+            t.join();
+
+            auto stop = std::chrono::steady_clock::now(); // Stop measure the time
+
+            std::cout << "Throughput of the concurrent::queue::BoundedSPSCByteQueue with mixed message sizes:" << std::endl;
+            std::cout << concurrent::benchmark::GetThroughput(iterations, start, stop) << " ops/ms" << std::endl;
+        }
+
+        {
+            using Message = FixedSizeMessage<kMaxMessageSize>;
+            concurrent::queue::BoundedSPSCQueue<Message, BufferSize / sizeof(Message) - 1> q{};
+
+            auto t = std::thread([&q, iterations, consumer_cpu] {
+                concurrent::benchmark::PinThread(consumer_cpu);
+                std::vector<std::byte> result(kMaxMessageSize);
+                for (IterationsCount i = 0; i < iterations; ++i) {
+                    concurrent::queue::RingBufferSpan<Message> messages;
+                    while ((messages = q.Peek(1)).IsEmpty());
+                    std::memcpy(result.data(), messages.first_[0].data_, messages.first_[0].size_);
+                    q.Release(1);
+                }
+            });
+
+            concurrent::benchmark::PinThread(producer_cpu);
+
+            auto start = std::chrono::steady_clock::now(); // Start measure the time
+
+            for (IterationsCount i = 0; i < iterations; ++i) {
+                std::span<Message> slots;
+                while ((slots = q.Reserve(1)).empty());
+                slots[0].size_ = sizes[i];
+                std::memcpy(slots[0].data_, payload.data(), sizes[i]);
+                q.Commit(1);
+            }
+
+            t.join();
+
+            auto stop = std::chrono::steady_clock::now(); // Stop measure the time
+
+            std::cout << "Throughput of the concurrent::queue::BoundedSPSCQueue with mixed message sizes:" << std::endl;
+            std::cout << concurrent::benchmark::GetThroughput(iterations, start, stop) << " ops/ms" << std::endl;
+        }
+    }
+
+    // The same loops as for BoundedSPSCQueue in main. The segment size is equal to the bounded queue size,
+    // so the unbounded queue works on the fast path and the results show its overhead
+    template<std::size_t SegmentSize>
+    void MeasureUnboundedQueue(const IterationsCount iterations, int producer_cpu, int consumer_cpu) {
+        {
+            concurrent::queue::UnboundedSPSCQueue<int, SegmentSize> q{};
+            auto t = std::thread([&q, iterations, consumer_cpu] {
+                concurrent::benchmark::PinThread(consumer_cpu);
+                for (IterationsCount i = 0; i < iterations; ++i) {
+                    while (q.IsEmptyConsumer());
+                    q.Dequeue();
+                }
+            });
+
+            concurrent::benchmark::PinThread(producer_cpu);
+
+            auto start = std::chrono::steady_clock::now(); // Start measure the time
+
+            for (IterationsCount i = 0; i < iterations; ++i) {
+                q.Emplace(static_cast<int>(i));
+            }
+            t.join();
+
+            auto stop = std::chrono::steady_clock::now(); // Stop measure the time
+
+            std::cout << "Throughput of the concurrent::queue::UnboundedSPSCQueue:" << std::endl;
+            std::cout << concurrent::benchmark::GetThroughput(iterations, start, stop) << " ops/ms" << std::endl;
+        }
+
+        {
+            concurrent::queue::UnboundedSPSCQueue<int, SegmentSize> q1{}, q2{};
+
+            auto t = std::thread([&q1, &q2, iterations, consumer_cpu] {
+                concurrent::benchmark::PinThread(consumer_cpu);
+                for (IterationsCount i = 0; i < iterations; ++i) {
+                    while (q1.IsEmptyConsumer());
+                    q2.Emplace(*q1.Front());
+                    q1.Dequeue();
+                }
+            });
+
+            concurrent::benchmark::PinThread(producer_cpu);
+
+            auto start = std::chrono::steady_clock::now(); // Start measure the time
+
+            for (IterationsCount i = 0; i < iterations; ++i) {
+                q1.Emplace(static_cast<int>(i));
+                while (q2.IsEmptyConsumer());
+                q2.Dequeue();
+            }
+            t.join();
+
+            auto stop = std::chrono::steady_clock::now(); // Stop measure the time
+
+            std::cout << "Latency of the concurrent::queue::UnboundedSPSCQueue:" << std::endl;
+            std::cout << concurrent::benchmark::GetLatency(iterations, start, stop) << " ns RTT" << std::endl;
+        }
+    }
+
+} // End of namespace concurrent::benchmark::queue
 
 int main() {
     int cpu1 = 0;
@@ -71,6 +384,25 @@ int main() {
         std::cout << concurrent::benchmark::GetLatency(iterations, start, stop) << " ns RTT" << std::endl;
     }
 
+    for (std::size_t bulk_size = 1; bulk_size <= 256; bulk_size *= 2) {
+        concurrent::benchmark::queue::MeasureBulkThroughput<queueSize>(iterations, bulk_size, cpu2, cpu1);
+    }
+
+    // The small queue, so the producer often finds it full and requests the head
+    constexpr std::size_t lazyHeadQueueSize = 1024;
+    concurrent::benchmark::queue::MeasureLazyHeadThroughput<lazyHeadQueueSize, 1>(iterations, cpu2, cpu1);
+    concurrent::benchmark::queue::MeasureLazyHeadThroughput<lazyHeadQueueSize, 4>(iterations, cpu2, cpu1);
+    concurrent::benchmark::queue::MeasureLazyHeadThroughput<lazyHeadQueueSize, 16>(iterations, cpu2, cpu1);
+    concurrent::benchmark::queue::MeasureLazyHeadThroughput<lazyHeadQueueSize, 64>(iterations, cpu2, cpu1);
+
+    concurrent::benchmark::queue::MeasureFlaggedQueue<lazyHeadQueueSize>(iterations, cpu2, cpu1);
+
+    concurrent::benchmark::queue::MeasureBatchedThroughput<queueSize>(iterations, cpu2, cpu1);
+
+    concurrent::benchmark::queue::MeasureMixedSizeThroughput<1 << 20>(iterations, cpu2, cpu1);
+
+    concurrent::benchmark::queue::MeasureUnboundedQueue<queueSize>(iterations, cpu2, cpu1);
+
 
     {
         boost::lockfree::spsc_queue<int> q(queueSize);
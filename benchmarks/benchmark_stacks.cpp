@@ -64,8 +64,34 @@ namespace concurrent::benchmark::stacks {
         std::cout << concurrent::benchmark::GetThroughput(iterations, start, stop) << " ops/ms" << std::endl;
     }
 
-    void MeasureLatency() {
-        //todo
+    // Round trip time of the value, which is pushed to the first stack and returned back through the second one
+    template<typename Stack, typename... Args>
+    void MeasureLatency(const IterationsCount iterations, std::array<int, 2> cpu, const std::string& stack_name, const Args&... args) {
+        Stack ping{args...}, pong{args...};
+        const concurrent::benchmark::TscClock clock;
+        concurrent::benchmark::LatencyHistogram histogram;
+
+        auto t = std::thread([&ping, &pong, iterations, &cpu] {
+            concurrent::benchmark::PinThread(cpu[1]);
+            int result = 0;
+            for (int i = 0; i < iterations; ++i) {
+                while (!ping.Pop(result));
+                pong.Push(result);
+            }
+        });
+
+        concurrent::benchmark::PinThread(cpu[0]);
+        int result = 0;
+        for (int i = 0; i < iterations; ++i) {
+            const auto start = clock.Now();
+            ping.Push(i);
+            while (!pong.Pop(result));
+            histogram.Record(clock.ToNanoseconds(clock.Now() - start));
+        }
+        t.join();
+
+        std::cout << "RTT latency of the " << stack_name << ": " << std::endl;
+        concurrent::benchmark::PrintPercentiles(histogram);
     }
 
 
@@ -143,5 +169,20 @@ int main() {
             "boost::lockfree::stack",
             iterations);
 
+    concurrent::benchmark::stacks::MeasureLatency<concurrent::stack::UnboundedLockFreeStack<int>>(
+            iterations,
+            cpu,
+            "concurrent::stack::UnboundedLockFreeStack");
+
+    concurrent::benchmark::stacks::MeasureLatency<concurrent::stack::UnboundedSpinLockedStack<int>>(
+            iterations,
+            cpu,
+            "concurrent::stack::UnboundedSpinLockedStack");
+
+    concurrent::benchmark::stacks::MeasureLatency<concurrent::stack::UnboundedMutexLockedStack<int>>(
+            iterations,
+            cpu,
+            "concurrent::stack::UnboundedMutexLockedStack");
+
     return 0;
 }
@@ -4,6 +4,17 @@
 #include <pthread.h>
 #include <sched.h>
 #include <chrono>
+#include <iostream>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#include <x86intrin.h>
+#define CONCURRENT_BENCHMARK_TSC 1
+#endif
 
 #include "utils.h"
 
@@ -46,6 +57,148 @@ namespace concurrent::benchmark {
         return std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count() / iterations;
     }
 
+
+    // Reads the time stamp counter, which is calibrated against std::chrono::steady_clock.
+    // The reads are ordered with the surrounding instructions, so they do not move into or out of the measured code.
+    // Falls back to std::chrono::steady_clock on the platforms without TSC
+    class TscClock {
+    public:
+        using Ticks = std::uint64_t;
+
+        TscClock();
+
+        Ticks Now() const noexcept;
+        // The ticks are signed, because the counters of the different cores may be slightly out of sync,
+        // so the difference of the counters, which are read on the different cores, may be negative
+        std::int64_t ToNanoseconds(std::int64_t ticks) const noexcept;
+
+    private:
+        static Ticks ReadCounter() noexcept;
+
+        double nanoseconds_per_tick_{1.0};
+    };
+
+    // Histogram with the logarithmic buckets, which are split into kSubBucketsCount linear sub buckets (like HdrHistogram).
+    // The relative error of the recorded values is less than 1 / kSubBucketsCount
+    class LatencyHistogram {
+    public:
+        static constexpr std::size_t kSubBucketBits = 5;
+        static constexpr std::size_t kSubBucketsCount = std::size_t{1} << kSubBucketBits;
+
+        void Record(std::int64_t value) noexcept;
+
+        // Returns the upper bound of the bucket, which contains the percentile (from 0 to 100)
+        std::int64_t GetPercentile(double percentile) const noexcept;
+        std::int64_t GetMax() const noexcept;
+        std::uint64_t GetCount() const noexcept;
+
+    private:
+        static constexpr std::size_t kBucketsCount = kSubBucketsCount * (64 - kSubBucketBits + 1);
+
+        static std::size_t GetBucketIndex(std::uint64_t value) noexcept;
+        static std::uint64_t GetBucketUpperBound(std::size_t index) noexcept;
+
+        std::array<std::uint64_t, kBucketsCount> counts_{};
+        std::uint64_t count_{0};
+        std::int64_t max_{0};
+    };
+
+    // Prints p50, p99, p99.9 and max of the histogram in nanoseconds
+    inline void PrintPercentiles(const LatencyHistogram& histogram) {
+        std::cout << "p50: " << histogram.GetPercentile(50) << " ns, "
+                  << "p99: " << histogram.GetPercentile(99) << " ns, "
+                  << "p99.9: " << histogram.GetPercentile(99.9) << " ns, "
+                  << "max: " << histogram.GetMax() << " ns" << std::endl;
+    }
+
+
+    // TscClock
+    inline TscClock::TscClock() {
+#ifdef CONCURRENT_BENCHMARK_TSC
+        const auto start_time = std::chrono::steady_clock::now();
+        const Ticks start_ticks = ReadCounter();
+
+        auto stop_time = start_time;
+        while (stop_time - start_time < std::chrono::milliseconds(10)) {
+            stop_time = std::chrono::steady_clock::now();
+        }
+        const Ticks stop_ticks = ReadCounter();
+
+        nanoseconds_per_tick_ = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(stop_time - start_time).count()) /
+                                static_cast<double>(stop_ticks - start_ticks);
+#endif
+    }
+
+    inline TscClock::Ticks TscClock::Now() const noexcept {
+        return ReadCounter();
+    }
+
+    inline std::int64_t TscClock::ToNanoseconds(std::int64_t ticks) const noexcept {
+        return static_cast<std::int64_t>(static_cast<double>(ticks) * nanoseconds_per_tick_);
+    }
+
+    inline TscClock::Ticks TscClock::ReadCounter() noexcept {
+#ifdef CONCURRENT_BENCHMARK_TSC
+        // rdtscp waits for the previous instructions, lfence holds the next ones until the counter is read
+        unsigned int processor_id;
+        const Ticks ticks = __rdtscp(&processor_id);
+        _mm_lfence();
+        return ticks;
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+
+    // LatencyHistogram
+    inline void LatencyHistogram::Record(std::int64_t value) noexcept {
+        value = std::max<std::int64_t>(value, 0);
+        ++counts_[GetBucketIndex(value)];
+        ++count_;
+        max_ = std::max(max_, value);
+    }
+
+    inline std::int64_t LatencyHistogram::GetPercentile(double percentile) const noexcept {
+        if (!count_) {
+            return 0;
+        }
+
+        const auto required_count = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(percentile / 100.0 * static_cast<double>(count_) + 0.5));
+        std::uint64_t count = 0;
+        for (std::size_t i = 0; i < kBucketsCount; ++i) {
+            count += counts_[i];
+            if (count >= required_count) {
+                return std::min<std::int64_t>(static_cast<std::int64_t>(GetBucketUpperBound(i)), max_);
+            }
+        }
+        return max_;
+    }
+
+    inline std::int64_t LatencyHistogram::GetMax() const noexcept {
+        return max_;
+    }
+
+    inline std::uint64_t LatencyHistogram::GetCount() const noexcept {
+        return count_;
+    }
+
+    inline std::size_t LatencyHistogram::GetBucketIndex(std::uint64_t value) noexcept {
+        if (value < kSubBucketsCount) {
+            return value;
+        }
+        const std::size_t shift = std::bit_width(value) - 1 - kSubBucketBits;
+        return kSubBucketsCount + shift * kSubBucketsCount + ((value >> shift) - kSubBucketsCount);
+    }
+
+    inline std::uint64_t LatencyHistogram::GetBucketUpperBound(std::size_t index) noexcept {
+        if (index < kSubBucketsCount) {
+            return index;
+        }
+        const std::size_t shift = (index - kSubBucketsCount) / kSubBucketsCount;
+        const std::uint64_t sub_bucket = (index - kSubBucketsCount) % kSubBucketsCount;
+        return ((kSubBucketsCount + sub_bucket) << shift) + (std::uint64_t{1} << shift) - 1;
+    }
+
 }
 
 #endif //LOCK_FREE_DATA_STRUCTURES_BENCHMARK_UTILS_H
@@ -0,0 +1,116 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <time.h>
+
+#include "benchmark_utils.h"
+
+#include "wait.h"
+#include "bounded_sp_sc_queue.h"
+
+namespace concurrent::benchmark::queue {
+
+    template<typename WaitStrategy>
+    using Queue = concurrent::queue::BoundedSPSCQueue<int64_t, 1024, std::allocator<int64_t>, WaitStrategy>;
+
+    std::chrono::nanoseconds GetThreadCpuTime() {
+        timespec time{};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+        return std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+    }
+
+    // Round trip time between two threads, which are never idle
+    template<typename WaitStrategy>
+    void MeasureLatency(const std::string& name, const IterationsCount iterations, int producer_cpu, int consumer_cpu) {
+        Queue<WaitStrategy> q1{}, q2{};
+
+        auto t = std::thread([&] {
+            concurrent::benchmark::PinThread(consumer_cpu);
+            int64_t message = 0;
+            for (IterationsCount i = 0; i < iterations; ++i) {
+                q1.BlockingDequeue(message);
+                q2.BlockingEnqueue(message);
+            }
+        });
+
+        concurrent::benchmark::PinThread(producer_cpu);
+
+        auto start = std::chrono::steady_clock::now(); // Start measure the time
+
+        int64_t message = 0;
+        for (IterationsCount i = 0; i < iterations; ++i) {
+            q1.BlockingEnqueue(i);
+            q2.BlockingDequeue(message);
+        }
+        t.join();
+
+        auto stop = std::chrono::steady_clock::now(); // Stop measure the time
+
+        std::cout << "Latency of the concurrent::queue::BoundedSPSCQueue with " << name << ":" << std::endl;
+        std::cout << concurrent::benchmark::GetLatency(iterations, start, stop) << " ns RTT" << std::endl;
+    }
+
+    // The producer sends a message every interval, so the consumer is idle most of the time.
+    // Shows how much CPU the waiting consumer burns and how fast it wakes up
+    template<typename WaitStrategy>
+    void MeasureIdleConsumer(const std::string& name, const IterationsCount iterations, std::chrono::microseconds interval,
+                             int producer_cpu, int consumer_cpu) {
+        Queue<WaitStrategy> q{};
+
+        std::chrono::nanoseconds total_delay{0};
+        std::chrono::nanoseconds consumer_cpu_time{0};
+
+        auto t = std::thread([&] {
+            concurrent::benchmark::PinThread(consumer_cpu);
+            const auto cpu_start = GetThreadCpuTime();
+
+            int64_t sent_time = 0;
+            for (IterationsCount i = 0; i < iterations; ++i) {
+                q.BlockingDequeue(sent_time);
+                total_delay += std::chrono::steady_clock::now().time_since_epoch() - std::chrono::nanoseconds(sent_time);
+            }
+
+            consumer_cpu_time = GetThreadCpuTime() - cpu_start;
+        });
+
+        concurrent::benchmark::PinThread(producer_cpu);
+
+        auto start = std::chrono::steady_clock::now(); // Start measure the time
+
+        for (IterationsCount i = 0; i < iterations; ++i) {
+            std::this_thread::sleep_for(interval);
+            q.BlockingEnqueue(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+        t.join();
+
+        auto stop = std::chrono::steady_clock::now(); // Stop measure the time
+
+        std::cout << "Idle consumer of the concurrent::queue::BoundedSPSCQueue with " << name << ":" << std::endl;
+        std::cout << total_delay.count() / iterations << " ns wake up latency, "
+                  << consumer_cpu_time.count() * 100 / std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count()
+                  << "% consumer CPU usage" << std::endl;
+    }
+
+    template<typename WaitStrategy>
+    void Measure(const std::string& name, int producer_cpu, int consumer_cpu) {
+        const IterationsCount iterations = 100000;
+        const IterationsCount idle_iterations = 1000;
+        const std::chrono::microseconds interval{1000};
+
+        MeasureLatency<WaitStrategy>(name, iterations, producer_cpu, consumer_cpu);
+        MeasureIdleConsumer<WaitStrategy>(name, idle_iterations, interval, producer_cpu, consumer_cpu);
+    }
+
+} // End of namespace concurrent::benchmark::queue
+
+int main() {
+    int cpu1 = 0;
+    int cpu2 = 1;
+
+    concurrent::benchmark::queue::Measure<concurrent::wait::BusySpinWaitStrategy>("BusySpinWaitStrategy", cpu1, cpu2);
+    concurrent::benchmark::queue::Measure<concurrent::wait::SpinYieldWaitStrategy<>>("SpinYieldWaitStrategy", cpu1, cpu2);
+    concurrent::benchmark::queue::Measure<concurrent::wait::SpinParkWaitStrategy<>>("SpinParkWaitStrategy", cpu1, cpu2);
+
+    return 0;
+}
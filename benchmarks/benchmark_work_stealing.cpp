@@ -0,0 +1,190 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+#include "benchmark_utils.h"
+
+#include "wait.h"
+#include "bounded_mp_mc_queue.h"
+#include "work_stealing_executor.h"
+
+namespace concurrent::benchmark::executor {
+
+    inline constexpr std::size_t kSharedQueueCapacity = 1 << 16;
+    inline constexpr int kFibCutoff = 12;
+    inline constexpr std::size_t kParallelForGrain = 1024;
+
+    // The pool, in which all workers take the tasks from one BoundedMPMCQueue. It has the same interface as
+    // WorkStealingExecutor. If the queue is full, the task is run by the thread, which submits it
+    class SharedQueueExecutor {
+    public:
+        explicit SharedQueueExecutor(std::size_t workers_count) : queue_(kSharedQueueCapacity) {
+            for (std::size_t i = 0; i < workers_count; ++i) {
+                workers_.emplace_back([this] {
+                    while (true) {
+                        Task* task = nullptr;
+                        wait_strategy_.Wait([&] { return queue_.TryDequeue(task) || is_stopped_.load(std::memory_order_acquire); });
+                        if (!task) {
+                            break;
+                        }
+                        Run(task);
+                    }
+                });
+            }
+        }
+
+        template<typename F>
+        void Submit(F&& function) {
+            Task* task = new concurrent::executor::details::FunctionTask<std::decay_t<F>>(std::forward<F>(function));
+            if (!queue_.TryEnqueue(task)) {
+                Run(task);
+                return;
+            }
+            wait_strategy_.Notify();
+        }
+
+        template<typename Condition>
+        void RunUntil(Condition&& condition) {
+            while (!condition()) {
+                Task* task = nullptr;
+                if (queue_.TryDequeue(task)) {
+                    Run(task);
+                } else {
+                    concurrent::wait::Wait();
+                }
+            }
+        }
+
+        ~SharedQueueExecutor() {
+            is_stopped_.store(true, std::memory_order_release);
+            wait_strategy_.Notify();
+            for (auto& worker : workers_) {
+                worker.join();
+            }
+        }
+
+    private:
+        using Task = concurrent::executor::details::Task;
+
+        static void Run(Task* task) {
+            std::unique_ptr<Task> owned_task{task};
+            owned_task->Run();
+        }
+
+        concurrent::queue::BoundedMPMCQueue<Task*> queue_;
+        std::atomic<bool> is_stopped_{false};
+        concurrent::wait::SpinParkWaitStrategy<> wait_strategy_;
+        std::vector<std::thread> workers_;
+    };
+
+    std::int64_t SerialFib(int n) {
+        return n < 2 ? n : SerialFib(n - 1) + SerialFib(n - 2);
+    }
+
+    // Forks the first subproblem, computes the second one and joins the first one
+    template<typename Executor>
+    std::int64_t Fib(Executor& executor, int n) {
+        if (n < kFibCutoff) {
+            return SerialFib(n);
+        }
+
+        std::int64_t x = 0;
+        std::atomic<bool> is_done{false};
+        executor.Submit([&executor, &x, &is_done, n] {
+            x = Fib(executor, n - 1);
+            is_done.store(true, std::memory_order_release);
+        });
+
+        const std::int64_t y = Fib(executor, n - 2);
+        executor.RunUntil([&is_done] { return is_done.load(std::memory_order_acquire); });
+        return x + y;
+    }
+
+    // Splits [first, last) in halves until the range is not greater than the grain
+    template<typename Executor>
+    std::int64_t ParallelSum(Executor& executor, const std::vector<std::int64_t>& values, std::size_t first, std::size_t last) {
+        if (last - first <= kParallelForGrain) {
+            std::int64_t sum = 0;
+            for (std::size_t i = first; i < last; ++i) {
+                sum += values[i];
+            }
+            return sum;
+        }
+
+        const std::size_t middle = first + (last - first) / 2;
+
+        std::int64_t right_sum = 0;
+        std::atomic<bool> is_done{false};
+        executor.Submit([&executor, &values, &right_sum, &is_done, middle, last] {
+            right_sum = ParallelSum(executor, values, middle, last);
+            is_done.store(true, std::memory_order_release);
+        });
+
+        const std::int64_t left_sum = ParallelSum(executor, values, first, middle);
+        executor.RunUntil([&is_done] { return is_done.load(std::memory_order_acquire); });
+        return left_sum + right_sum;
+    }
+
+    // The tasks are forked from the thread, which is not a worker, so the root task goes through the injection queue
+    template<typename Executor, typename Function>
+    std::int64_t RunRoot(Executor& executor, Function&& function) {
+        std::int64_t result = 0;
+        std::atomic<bool> is_done{false};
+        executor.Submit([&] {
+            result = function();
+            is_done.store(true, std::memory_order_release);
+        });
+        executor.RunUntil([&is_done] { return is_done.load(std::memory_order_acquire); });
+        return result;
+    }
+
+    template<typename Executor>
+    void MeasureFib(const std::string& name, std::size_t workers_count, int n) {
+        Executor executor{workers_count};
+
+        auto start = std::chrono::steady_clock::now(); // Start measure the time
+        const std::int64_t result = RunRoot(executor, [&executor, n] { return Fib(executor, n); });
+        auto stop = std::chrono::steady_clock::now(); // Stop measure the time
+
+        std::cout << "Fib(" << n << ") = " << result << " with the " << name << " and " << workers_count << " workers:" << std::endl;
+        std::cout << std::chrono::duration_cast<std::chrono::microseconds>(stop - start).count() << " us" << std::endl;
+    }
+
+    template<typename Executor>
+    void MeasureParallelFor(const std::string& name, std::size_t workers_count, std::size_t size) {
+        Executor executor{workers_count};
+        const std::vector<std::int64_t> values(size, 1);
+
+        auto start = std::chrono::steady_clock::now(); // Start measure the time
+        const std::int64_t result = RunRoot(executor, [&executor, &values] { return ParallelSum(executor, values, 0, values.size()); });
+        auto stop = std::chrono::steady_clock::now(); // Stop measure the time
+
+        std::cout << "Parallel sum of " << result << " elements with the " << name << " and " << workers_count << " workers:" << std::endl;
+        std::cout << std::chrono::duration_cast<std::chrono::microseconds>(stop - start).count() << " us" << std::endl;
+    }
+
+} // End of namespace concurrent::benchmark::executor
+
+int main() {
+    using WorkStealingExecutor = concurrent::executor::WorkStealingExecutor<>;
+    using SharedQueueExecutor = concurrent::benchmark::executor::SharedQueueExecutor;
+
+    const int fib_n = 32;
+    const std::size_t parallel_for_size = 1 << 26;
+
+    for (std::size_t workers_count = 1; workers_count <= 8; workers_count *= 2) {
+        concurrent::benchmark::executor::MeasureFib<WorkStealingExecutor>("concurrent::executor::WorkStealingExecutor", workers_count, fib_n);
+        concurrent::benchmark::executor::MeasureFib<SharedQueueExecutor>("shared concurrent::queue::BoundedMPMCQueue", workers_count, fib_n);
+    }
+
+    for (std::size_t workers_count = 1; workers_count <= 8; workers_count *= 2) {
+        concurrent::benchmark::executor::MeasureParallelFor<WorkStealingExecutor>("concurrent::executor::WorkStealingExecutor", workers_count, parallel_for_size);
+        concurrent::benchmark::executor::MeasureParallelFor<SharedQueueExecutor>("shared concurrent::queue::BoundedMPMCQueue", workers_count, parallel_for_size);
+    }
+
+    return 0;
+}
@@ -0,0 +1,208 @@
+#ifndef LOCK_FREE_WORK_STEALING_DEQUE_H
+#define LOCK_FREE_WORK_STEALING_DEQUE_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <bit>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+#include "cache_line.h"
+#include "utils.h"
+
+namespace concurrent::deque {
+
+    inline constexpr std::size_t kDefaultDequeCapacity = 256;
+
+    namespace details {
+
+        // The circular array of the deque. The cells are atomic, because the thief can read the cell,
+        // which the owner overwrites after the thief loses the race for top_
+        template<typename T>
+        class WorkStealingArray {
+        public:
+            explicit WorkStealingArray(std::size_t capacity);
+
+            T Load(std::int64_t i) const noexcept;
+            void Store(std::int64_t i, T element) noexcept;
+
+            // Returns the array of the doubled capacity with the elements of [top, bottom)
+            WorkStealingArray* Grow(std::int64_t top, std::int64_t bottom) const;
+
+            std::size_t GetCapacity() const noexcept;
+
+        private:
+            std::size_t capacity_;
+            std::size_t index_mask_;
+            std::unique_ptr<std::atomic<T>[]> cells_;
+        };
+
+    }
+
+    // Chase-Lev work-stealing deque with the memory orders from "Correct and Efficient Work-Stealing for Weak Memory Models".
+    // The owner pushes and pops the elements at the bottom, the thieves steal them from the top.
+    // Only the owner's Pop and the thieves race for the last element, so the owner's fast path has no atomic RMW operations.
+    // The owner grows the array when it is full. The thieves can still read the old array, so it is kept until
+    // the deque is destroyed (the old arrays take less memory than the current one)
+    template<typename T> requires utils::IsTriviallyCopyable<T>
+    class WorkStealingDeque {
+    public:
+        explicit WorkStealingDeque(std::size_t capacity = kDefaultDequeCapacity);
+
+        WorkStealingDeque(const WorkStealingDeque&) = delete;
+        WorkStealingDeque(WorkStealingDeque&&) = delete;
+        WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+        WorkStealingDeque& operator=(WorkStealingDeque&&) = delete;
+
+        // Owner methods
+        void Push(T element);
+        bool Pop(T& element) noexcept;
+
+        // Thief method. Returns false if the deque is empty or another thread took the element first
+        bool Steal(T& element) noexcept;
+
+        [[nodiscard]] bool IsEmpty() const noexcept;
+        [[nodiscard]] std::size_t GetSize() const noexcept;
+        [[nodiscard]] std::size_t GetCapacity() const noexcept;
+
+        ~WorkStealingDeque() = default;
+
+    private:
+        using Array = details::WorkStealingArray<T>;
+
+    private:
+        alignas(cache::kCacheLineSize) std::atomic<std::int64_t> top_{0};
+        alignas(cache::kCacheLineSize) std::atomic<std::int64_t> bottom_{0};
+        alignas(cache::kCacheLineSize) std::atomic<Array*> array_;
+
+        PADDING(padding0_, sizeof(std::atomic<Array*>));
+
+        std::vector<std::unique_ptr<Array>> arrays_; // The current and the old arrays. Used only by the owner
+    };
+
+
+    // Implementation
+    namespace details {
+
+        template<typename T>
+        WorkStealingArray<T>::WorkStealingArray(std::size_t capacity)
+                : capacity_(std::bit_ceil(std::max<std::size_t>(capacity, 2))), index_mask_(capacity_ - 1),
+                  cells_(std::make_unique<std::atomic<T>[]>(capacity_)) {}
+
+        template<typename T>
+        T WorkStealingArray<T>::Load(std::int64_t i) const noexcept {
+            return cells_[static_cast<std::size_t>(i) & index_mask_].load(std::memory_order_relaxed);
+        }
+
+        template<typename T>
+        void WorkStealingArray<T>::Store(std::int64_t i, T element) noexcept {
+            cells_[static_cast<std::size_t>(i) & index_mask_].store(element, std::memory_order_relaxed);
+        }
+
+        template<typename T>
+        WorkStealingArray<T>* WorkStealingArray<T>::Grow(std::int64_t top, std::int64_t bottom) const {
+            auto* array = new WorkStealingArray(2 * capacity_);
+            for (std::int64_t i = top; i < bottom; ++i) {
+                array->Store(i, Load(i));
+            }
+            return array;
+        }
+
+        template<typename T>
+        std::size_t WorkStealingArray<T>::GetCapacity() const noexcept {
+            return capacity_;
+        }
+
+    }
+
+    template<typename T> requires utils::IsTriviallyCopyable<T>
+    WorkStealingDeque<T>::WorkStealingDeque(std::size_t capacity) {
+        arrays_.emplace_back(std::make_unique<Array>(capacity));
+        array_.store(arrays_.back().get(), std::memory_order_relaxed);
+    }
+
+    template<typename T> requires utils::IsTriviallyCopyable<T>
+    void WorkStealingDeque<T>::Push(T element) {
+        const std::int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        const std::int64_t top = top_.load(std::memory_order_acquire);
+        Array* array = array_.load(std::memory_order_relaxed);
+
+        if (bottom - top > static_cast<std::int64_t>(array->GetCapacity()) - 1) {
+            arrays_.emplace_back(array->Grow(top, bottom));
+            array = arrays_.back().get();
+            array_.store(array, std::memory_order_release);
+        }
+
+        array->Store(bottom, element);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    template<typename T> requires utils::IsTriviallyCopyable<T>
+    bool WorkStealingDeque<T>::Pop(T& element) noexcept {
+        const std::int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        Array* array = array_.load(std::memory_order_relaxed);
+        bottom_.store(bottom, std::memory_order_relaxed);
+
+        // Orders the store of the bottom with the load of the top, so the owner and the thief cannot both take the last element
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t top = top_.load(std::memory_order_relaxed);
+
+        if (top > bottom) {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        element = array->Load(bottom);
+        if (top < bottom) {
+            return true;
+        }
+
+        // The last element. The owner takes it only if it wins the race for the top
+        const bool is_taken = top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+        return is_taken;
+    }
+
+    template<typename T> requires utils::IsTriviallyCopyable<T>
+    bool WorkStealingDeque<T>::Steal(T& element) noexcept {
+        std::int64_t top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::int64_t bottom = bottom_.load(std::memory_order_acquire);
+
+        if (top >= bottom) {
+            return false;
+        }
+
+        Array* array = array_.load(std::memory_order_acquire);
+        const T stolen = array->Load(top);
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return false;
+        }
+
+        element = stolen;
+        return true;
+    }
+
+    template<typename T> requires utils::IsTriviallyCopyable<T>
+    bool WorkStealingDeque<T>::IsEmpty() const noexcept {
+        return GetSize() == 0;
+    }
+
+    template<typename T> requires utils::IsTriviallyCopyable<T>
+    std::size_t WorkStealingDeque<T>::GetSize() const noexcept {
+        const std::int64_t bottom = bottom_.load(std::memory_order_acquire);
+        const std::int64_t top = top_.load(std::memory_order_acquire);
+        return bottom > top ? static_cast<std::size_t>(bottom - top) : 0;
+    }
+
+    template<typename T> requires utils::IsTriviallyCopyable<T>
+    std::size_t WorkStealingDeque<T>::GetCapacity() const noexcept {
+        return array_.load(std::memory_order_acquire)->GetCapacity();
+    }
+
+} // End of namespace concurrent::deque
+
+#endif //LOCK_FREE_WORK_STEALING_DEQUE_H
@@ -0,0 +1,263 @@
+#ifndef LOCK_FREE_WORK_STEALING_EXECUTOR_H
+#define LOCK_FREE_WORK_STEALING_EXECUTOR_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+#include <cstdint>
+#include <cstddef>
+
+#include "cache_line.h"
+#include "wait.h"
+#include "random.h"
+#include "work_stealing_deque.h"
+#include "unbounded_mp_mc_queue.h"
+
+namespace concurrent::executor {
+
+    namespace details {
+
+        class Task {
+        public:
+            virtual void Run() = 0;
+            virtual ~Task() = default;
+        };
+
+        template<typename F>
+        class FunctionTask final : public Task {
+        public:
+            explicit FunctionTask(F&& function) : function_(std::move(function)) {}
+            explicit FunctionTask(const F& function) : function_(function) {}
+
+            void Run() override {
+                function_();
+            }
+
+        private:
+            F function_;
+        };
+
+    }
+
+    // Thread pool, in which every worker has its own WorkStealingDeque. The task submitted by the worker is pushed
+    // to the bottom of its deque, and the tasks submitted by the other threads go to the shared injection queue.
+    // The worker without the tasks pops its deque, then takes the task from the injection queue, then steals from the top
+    // of the deque of the random worker, and then waits with the WaitStrategy. The waiting workers are counted, so Submit
+    // only reads the counter, while all workers are busy, and wakes one worker per task otherwise
+    template<typename WaitStrategy = wait::SpinParkWaitStrategy<>>
+    class WorkStealingExecutor {
+    public:
+        explicit WorkStealingExecutor(std::size_t workers_count = std::thread::hardware_concurrency());
+
+        WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+        WorkStealingExecutor(WorkStealingExecutor&&) = delete;
+        WorkStealingExecutor& operator=(const WorkStealingExecutor&) = delete;
+        WorkStealingExecutor& operator=(WorkStealingExecutor&&) = delete;
+
+        template<typename F>
+        void Submit(F&& function);
+
+        // Runs the tasks of the executor until the condition is true. The task, which waits for the tasks it submitted,
+        // calls it instead of blocking the worker
+        template<typename Condition>
+        void RunUntil(Condition&& condition);
+
+        [[nodiscard]] std::size_t GetWorkersCount() const noexcept;
+
+        // Runs the tasks, which are already submitted, and joins the workers
+        ~WorkStealingExecutor();
+
+    private:
+        using Task = details::Task;
+
+        struct Worker {
+            explicit Worker(WorkStealingExecutor* executor, std::uint64_t seed) : executor_(executor), random_(seed) {}
+
+            deque::WorkStealingDeque<Task*> deque_;
+            WorkStealingExecutor* executor_;
+            utils::XorShift64Random random_; // Selects the victims to steal from. Used only by the worker
+            std::thread thread_;
+        };
+
+        void RunWorker(Worker* worker);
+
+        // Returns the worker of the current thread, if it is the worker of this executor
+        Worker* GetCurrentWorker() const noexcept;
+
+        // Pops the own deque, then takes the task from the injection queue, then tries to steal once from every worker
+        Task* FindTask(Worker* worker);
+        Task* Steal(Worker* worker);
+
+        static void Run(Task* task);
+
+    private:
+        static inline thread_local Worker* current_worker_{nullptr};
+
+        std::vector<std::unique_ptr<Worker>> workers_;
+
+        queue::UnboundedMPMCQueue<Task*> injection_queue_;
+
+        alignas(cache::kCacheLineSize) std::atomic<bool> is_stopped_{false};
+
+        PADDING(padding0_, sizeof(std::atomic<bool>));
+
+        alignas(cache::kCacheLineSize) std::atomic<std::size_t> idle_workers_count_{0}; // The workers in the WaitStrategy
+
+        PADDING(padding1_, sizeof(std::atomic<std::size_t>));
+
+        [[no_unique_address]] WaitStrategy wait_strategy_; // Idle workers wait on it for the new tasks
+    };
+
+
+    // Implementation
+    template<typename WaitStrategy>
+    WorkStealingExecutor<WaitStrategy>::WorkStealingExecutor(std::size_t workers_count) {
+        workers_count = std::max<std::size_t>(workers_count, 1);
+
+        workers_.reserve(workers_count);
+        for (std::size_t i = 0; i < workers_count; ++i) {
+            workers_.emplace_back(std::make_unique<Worker>(this, 2 * i + 1));
+        }
+
+        // The workers are started after all deques are created, because they steal from each other
+        for (auto& worker : workers_) {
+            worker->thread_ = std::thread([this, worker = worker.get()] { RunWorker(worker); });
+        }
+    }
+
+    template<typename WaitStrategy>
+    template<typename F>
+    void WorkStealingExecutor<WaitStrategy>::Submit(F&& function) {
+        Task* task = new details::FunctionTask<std::decay_t<F>>(std::forward<F>(function));
+
+        if (Worker* worker = GetCurrentWorker()) {
+            worker->deque_.Push(task);
+        } else {
+            injection_queue_.Enqueue(task);
+        }
+
+        // Orders the publication of the task with the load of the counter. The worker increments the counter before
+        // it looks for the task, so either the worker finds the task, or the counter shows the worker
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (idle_workers_count_.load(std::memory_order_relaxed)) {
+            wait_strategy_.NotifyOne();
+        }
+    }
+
+    template<typename WaitStrategy>
+    template<typename Condition>
+    void WorkStealingExecutor<WaitStrategy>::RunUntil(Condition&& condition) {
+        Worker* worker = GetCurrentWorker();
+        while (!condition()) {
+            if (Task* task = FindTask(worker)) {
+                Run(task);
+            } else {
+                wait::Wait();
+            }
+        }
+    }
+
+    template<typename WaitStrategy>
+    std::size_t WorkStealingExecutor<WaitStrategy>::GetWorkersCount() const noexcept {
+        return workers_.size();
+    }
+
+    template<typename WaitStrategy>
+    WorkStealingExecutor<WaitStrategy>::~WorkStealingExecutor() {
+        is_stopped_.store(true, std::memory_order_release);
+        wait_strategy_.Notify();
+
+        for (auto& worker : workers_) {
+            worker->thread_.join();
+        }
+
+        // The worker can stop, when the last task is in the middle of the steal. The workers are joined,
+        // so their deques can be popped by this thread
+        bool is_drained = false;
+        while (!is_drained) {
+            is_drained = true;
+            Task* task = nullptr;
+            for (auto& worker : workers_) {
+                while (worker->deque_.Pop(task)) {
+                    Run(task);
+                    is_drained = false;
+                }
+            }
+            while (injection_queue_.TryDequeue(task)) {
+                Run(task);
+                is_drained = false;
+            }
+        }
+    }
+
+
+    template<typename WaitStrategy>
+    void WorkStealingExecutor<WaitStrategy>::RunWorker(Worker* worker) {
+        current_worker_ = worker;
+
+        while (true) {
+            Task* task = FindTask(worker);
+            if (!task) {
+                idle_workers_count_.fetch_add(1, std::memory_order_seq_cst);
+                wait_strategy_.Wait([&] { return (task = FindTask(worker)) != nullptr || is_stopped_.load(std::memory_order_acquire); });
+                idle_workers_count_.fetch_sub(1, std::memory_order_relaxed);
+            }
+
+            if (!task) {
+                break; // The executor is stopped and no task is left
+            }
+            Run(task);
+        }
+
+        current_worker_ = nullptr;
+    }
+
+    template<typename WaitStrategy>
+    typename WorkStealingExecutor<WaitStrategy>::Worker* WorkStealingExecutor<WaitStrategy>::GetCurrentWorker() const noexcept {
+        return current_worker_ && current_worker_->executor_ == this ? current_worker_ : nullptr;
+    }
+
+    template<typename WaitStrategy>
+    typename WorkStealingExecutor<WaitStrategy>::Task* WorkStealingExecutor<WaitStrategy>::FindTask(Worker* worker) {
+        Task* task = nullptr;
+        if (worker && worker->deque_.Pop(task)) {
+            return task;
+        }
+        if (injection_queue_.TryDequeue(task)) {
+            return task;
+        }
+        return Steal(worker);
+    }
+
+    template<typename WaitStrategy>
+    typename WorkStealingExecutor<WaitStrategy>::Task* WorkStealingExecutor<WaitStrategy>::Steal(Worker* worker) {
+        const std::size_t workers_count = workers_.size();
+
+        std::size_t first_victim = 0;
+        if (worker) {
+            first_victim = static_cast<std::size_t>(worker->random_.Next() % workers_count);
+        }
+
+        Task* task = nullptr;
+        for (std::size_t i = 0; i < workers_count; ++i) {
+            Worker* victim = workers_[(first_victim + i) % workers_count].get();
+            if (victim != worker && victim->deque_.Steal(task)) {
+                return task;
+            }
+        }
+        return nullptr;
+    }
+
+    template<typename WaitStrategy>
+    void WorkStealingExecutor<WaitStrategy>::Run(Task* task) {
+        std::unique_ptr<Task> owned_task{task};
+        owned_task->Run();
+    }
+
+} // End of namespace concurrent::executor
+
+#endif //LOCK_FREE_WORK_STEALING_EXECUTOR_H
@@ -6,47 +6,64 @@
 
 #include "lock.h"
 #include "wait.h"
+#include "instrumentation.h"
 
 namespace concurrent::lock {
 
-    class alignas(concurrent::cache::kCacheLineSize) SpinLock final : public Lock<SpinLock> {
+    // Counters is the instrumentation policy. It counts the iterations of Lock, which spin while the lock is taken
+    template<typename Counters = instrumentation::NoCounters>
+    class alignas(concurrent::cache::kCacheLineSize) BasicSpinLock final : public Lock<BasicSpinLock<Counters>> {
     public:
-        SpinLock() = default;
+        BasicSpinLock() = default;
 
-        SpinLock(const SpinLock& other) = delete;
-        SpinLock(SpinLock&& other) = delete;
-        SpinLock& operator=(const SpinLock& other) = delete;
-        SpinLock& operator=(SpinLock&& other) = delete;
+        BasicSpinLock(const BasicSpinLock& other) = delete;
+        BasicSpinLock(BasicSpinLock&& other) = delete;
+        BasicSpinLock& operator=(const BasicSpinLock& other) = delete;
+        BasicSpinLock& operator=(BasicSpinLock&& other) = delete;
 
         void Lock();
         bool TryLock();
         void Unlock();
 
-        ~SpinLock() = default;
+        [[nodiscard]] const Counters& GetCounters() const noexcept;
+
+        ~BasicSpinLock() = default;
 
     private:
         std::atomic<bool> locked_{false};
+        [[no_unique_address]] Counters counters_;
     };
 
-    void SpinLock::Lock() {
+    using SpinLock = BasicSpinLock<>;
+
+    template<typename Counters>
+    void BasicSpinLock<Counters>::Lock() {
         while (true) {
             if (!locked_.exchange(true, std::memory_order_release)) {
                 return;
             }
             while (locked_.load(std::memory_order_acquire)) {
+                counters_.Add(instrumentation::Event::kLockSpin);
                 concurrent::wait::Wait();
             }
         }
     }
 
-    bool SpinLock::TryLock() {
+    template<typename Counters>
+    bool BasicSpinLock<Counters>::TryLock() {
         return !locked_.load(std::memory_order_acquire) && !locked_.exchange(true, std::memory_order_release);
     }
 
-    void SpinLock::Unlock() {
+    template<typename Counters>
+    void BasicSpinLock<Counters>::Unlock() {
         locked_.store(false, std::memory_order_release);
     }
 
+    template<typename Counters>
+    const Counters& BasicSpinLock<Counters>::GetCounters() const noexcept {
+        return counters_;
+    }
+
 } // End of namespace concurrent::lock
 
 #endif //LOCK_FREE_SPIN_LOCK_H
@@ -2,26 +2,36 @@
 #define LOCK_FREE_BATCHED_BOUNDED_SP_SC_QUEUE_H
 
 #include <memory>
-#include <cmath>
 #include <atomic>
 #include <type_traits>
-#include <array>
 #include <cassert>
 #include <utility>
-#include <climits>
 #include <cstring>
+#include <span>
+#include <new>
+#include <chrono>
 
 #include "cache_line.h"
+#include "wait.h"
+#include "bounded_queue.h"
+#include "instrumentation.h"
 
 namespace concurrent::queue {
 
     namespace details {
 
         inline constexpr std::size_t kDefaultSlotSize = 16;
+        inline constexpr std::chrono::nanoseconds kDefaultIdleThreshold = std::chrono::microseconds(10);
 
+        // The elements are stored in the uninitialized storage and destroyed when they are read
         template<typename T, std::size_t Size = kDefaultSlotSize>
         class SPSCQueueSlot {
         public:
+            SPSCQueueSlot() = default;
+
+            SPSCQueueSlot(const SPSCQueueSlot&) = delete;
+            SPSCQueueSlot& operator=(const SPSCQueueSlot&) = delete;
+
             T* Front();
 
             template<typename... Args>
@@ -29,11 +39,24 @@ namespace concurrent::queue {
 
             void Dequeue();
 
+            std::span<T> Peek();
+            void Release(std::size_t count);
+
+            void Clear();
+
             bool IsEmpty();
             bool IsFull();
 
+            ~SPSCQueueSlot();
+
         private:
-            T buffer_[Size];
+            T* GetElement(std::size_t index) noexcept;
+
+            // Destroys the elements in [first, last). Does nothing for trivially destructible types
+            void DestroyElements(std::size_t first, std::size_t last) noexcept;
+
+        private:
+            std::aligned_storage_t<sizeof(T), alignof(T)> buffer_[Size];
             std::size_t head_{0};
             std::size_t tail_{0};
 
@@ -41,10 +64,18 @@ namespace concurrent::queue {
 
     }
 
-    template<typename T, std::size_t Capacity>
+    // The producer fills the batch of BatchSize elements without touching the shared indices.
+    // The batch is published when it is full, on Flush() or on FlushIfIdle() after the idle threshold.
+    // The consumer sees the elements only after their batch is published and reads the batches as a whole.
+    // Capacity is the number of batches. Counters is the instrumentation policy. It counts the reloads of the cached head and tail
+    template<typename T, std::size_t Capacity = kDynamicCapacity, typename Allocator = std::allocator<T>,
+             typename WaitStrategy = wait::BusySpinWaitStrategy, std::size_t BatchSize = details::kDefaultSlotSize,
+             typename Counters = instrumentation::NoCounters>
     class BatchedBoundedSPSCQueue final {
     public:
-        BatchedBoundedSPSCQueue() = default;
+        BatchedBoundedSPSCQueue() requires (Capacity != kDynamicCapacity);
+        explicit BatchedBoundedSPSCQueue(const Allocator& allocator) requires (Capacity != kDynamicCapacity);
+        explicit BatchedBoundedSPSCQueue(std::size_t capacity, const Allocator& allocator = Allocator()) requires (Capacity == kDynamicCapacity);
 
         BatchedBoundedSPSCQueue(const BatchedBoundedSPSCQueue&) = delete;
         BatchedBoundedSPSCQueue(BatchedBoundedSPSCQueue&&) = delete;
@@ -64,139 +95,251 @@ namespace concurrent::queue {
 
         bool Dequeue();
 
+        // Publishes the current batch even if it is not full
+        void Flush();
+
+        // Publishes the current batch if it was started more than the idle threshold ago.
+        // The producer calls it, when it has nothing to enqueue
+        void FlushIfIdle();
+
+        void SetIdleThreshold(std::chrono::nanoseconds idle_threshold) noexcept;
+
+        // Blocking versions of Emplace, Enqueue and Front. They wait with the WaitStrategy until the operation succeeds
+        template<typename... Args>
+        void BlockingEmplace(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>);
+
+        void BlockingEnqueue(const T& element) noexcept(std::is_nothrow_copy_constructible_v<T>);
+        void BlockingEnqueue(T&& element) noexcept(std::is_nothrow_move_constructible_v<T>);
+
+        T* BlockingFront();
+
+        // Returns the unread elements of the front published batch, which the consumer can read in place
+        std::span<T> Peek();
+
+        // Releases the first count elements of the peeked batch. Does nothing if the queue is empty
+        void Release(std::size_t count);
+
         bool IsEmptyConsumer();
-        std::size_t GetCapacity() const noexcept;
+        std::size_t GetCapacity() const noexcept; // The number of elements, which can be enqueued. One slot of the ring is always free
+
+        const Counters& GetCounters() const noexcept;
 
         ~BatchedBoundedSPSCQueue() = default;
 
     private:
-        static constexpr std::size_t GetBufferSize();
-        static constexpr std::size_t GetIndexMask();
+        using Slot = details::SPSCQueueSlot<T, BatchSize>;
+        using Clock = std::chrono::steady_clock;
+        using SlotAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Slot>;
+        using Buffer = details::RingBuffer<Slot, Capacity == kDynamicCapacity ? kDynamicCapacity : details::GetBufferSize(Capacity), SlotAllocator>;
+
+        std::size_t GetBufferSize() const noexcept;
+        std::size_t GetIndexMask() const noexcept;
 
-        bool MoveHead(std::size_t& head);
+        // Returns the batch the consumer reads from or nullptr if the queue is empty
+        Slot* LoadHeadSlot();
 
     private:
         PADDING(padding0_, 0);
 
-        details::SPSCQueueSlot<T> buffer_[GetBufferSize()];
+        Buffer buffer_;
 
-        PADDING(padding1_, 0);
+        PADDING(padding1_, sizeof(Buffer));
 
         alignas(concurrent::cache::kCacheLineSize) std::atomic<std::size_t> tail_{0};
         std::size_t cached_head_{0};
+        std::size_t batch_size_{0}; // The number of elements in the unpublished batch
+        Clock::time_point batch_start_{};
+        std::chrono::nanoseconds idle_threshold_{details::kDefaultIdleThreshold};
 
-        PADDING(padding2_, sizeof(std::atomic<std::size_t>) + sizeof(std::size_t));
+        PADDING(padding2_, sizeof(std::atomic<std::size_t>) + 2 * sizeof(std::size_t) + sizeof(Clock::time_point) + sizeof(std::chrono::nanoseconds));
 
         alignas(concurrent::cache::kCacheLineSize) std::atomic<std::size_t> head_{0};
         std::size_t cached_tail_{0};
 
         PADDING(padding3_, 0);
+
+        [[no_unique_address]] WaitStrategy producer_wait_strategy_; // The producer waits on it while the queue is full
+        [[no_unique_address]] WaitStrategy consumer_wait_strategy_; // The consumer waits on it while the queue is empty
+        [[no_unique_address]] Counters counters_;
     };
 
 
     // Implementation
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t BatchSize, typename Counters>
+    BatchedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, BatchSize, Counters>::BatchedBoundedSPSCQueue() requires (Capacity != kDynamicCapacity) : BatchedBoundedSPSCQueue(Allocator()) {}
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t BatchSize, typename Counters>
+    BatchedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, BatchSize, Counters>::BatchedBoundedSPSCQueue(const Allocator& allocator) requires (Capacity != kDynamicCapacity)
+            : buffer_(SlotAllocator(allocator)) {}
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t BatchSize, typename Counters>
+    BatchedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, BatchSize, Counters>::BatchedBoundedSPSCQueue(std::size_t capacity, const Allocator& allocator) requires (Capacity == kDynamicCapacity)
+            : buffer_(details::GetBufferSize(capacity), SlotAllocator(allocator)) {}
 
-    template<typename T, std::size_t Capacity>
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t BatchSize, typename Counters>
     template<typename... Args>
-    bool BatchedBoundedSPSCQueue<T, Capacity>::Emplace(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>) {
-        const std::size_t tail = tail_.load(std::memory_order_acquire);
-        std::size_t next_tail = (tail + 1) & GetIndexMask();
+    bool BatchedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, BatchSize, Counters>::Emplace(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>) {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
 
-        if (next_tail == cached_head_) {
-            cached_head_ = head_.load(std::memory_order_acquire);
+        if (!batch_size_) {
+            const std::size_t next_tail = (tail + 1) & GetIndexMask();
             if (next_tail == cached_head_) {
-                return false;
+                cached_head_ = head_.load(std::memory_order_acquire);
+                counters_.Add(instrumentation::Event::kCachedHeadRefresh);
+                if (next_tail == cached_head_) {
+                    return false;
+                }
             }
+
+            buffer_[tail].Clear();
+            batch_start_ = Clock::now();
         }
 
-        new (&buffer_[tail]) T(std::forward<Args>(args)...);
-        tail_.store(next_tail, std::memory_order_release);
+        buffer_[tail].Emplace(std::forward<Args>(args)...);
+        if (++batch_size_ == BatchSize) {
+            Flush();
+        }
 
         return true;
     }
 
-    template<typename T, std::size_t Capacity>
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t BatchSize, typename Counters>
     template<typename>
-    bool BatchedBoundedSPSCQueue<T, Capacity>::Enqueue(const T& element) noexcept(std::is_nothrow_copy_constructible_v<T>) {
+    bool BatchedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, BatchSize, Counters>::Enqueue(const T& element) noexcept(std::is_nothrow_copy_constructible_v<T>) {
         return Emplace(element);
     }
 
-    template<typename T, std::size_t Capacity>
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t BatchSize, typename Counters>
     template<typename>
-    bool BatchedBoundedSPSCQueue<T, Capacity>::Enqueue(T&& element) noexcept(std::is_nothrow_move_constructible_v<T>) {
+    bool BatchedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, BatchSize, Counters>::Enqueue(T&& element) noexcept(std::is_nothrow_move_constructible_v<T>) {
         return Emplace(std::forward<T>(element));
     }
 
-    template<typename T, std::size_t Capacity>
-    T* BatchedBoundedSPSCQueue<T, Capacity>::Front() {
-        std::size_t head = head_.load(std::memory_order_acquire);
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t BatchSize, typename Counters>
+    void BatchedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, BatchSize, Counters>::Flush() {
+        if (!batch_size_) {
+            return;
+        }
 
-        if (buffer_[head].IsEmpty()) { //todo
-            if (!MoveHead(head)) {
-                return nullptr;
-            }
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        tail_.store((tail + 1) & GetIndexMask(), std::memory_order_release);
+        batch_size_ = 0;
+        consumer_wait_strategy_.Notify();
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t BatchSize, typename Counters>
+    void BatchedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, BatchSize, Counters>::FlushIfIdle() {
+        if (batch_size_ && Clock::now() - batch_start_ >= idle_threshold_) {
+            Flush();
         }
+    }
 
-        return buffer_[head].Front();
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t BatchSize, typename Counters>
+    void BatchedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, BatchSize, Counters>::SetIdleThreshold(std::chrono::nanoseconds idle_threshold) noexcept {
+        idle_threshold_ = idle_threshold;
     }
 
-    template<typename T, std::size_t Capacity>
-    bool BatchedBoundedSPSCQueue<T, Capacity>::Dequeue() {
-        std::size_t head = head_.load(std::memory_order_acquire);
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t BatchSize, typename Counters>
+    T* BatchedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, BatchSize, Counters>::Front() {
+        Slot* slot = LoadHeadSlot();
+        return slot ? slot->Front() : nullptr;
+    }
 
-        if (buffer_[head].IsEmpty()) {
-            if (!MoveHead(head)) {
-                return false;
-            }
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t BatchSize, typename Counters>
+    bool BatchedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, BatchSize, Counters>::Dequeue() {
+        if (!LoadHeadSlot()) {
+            return false;
         }
 
-        buffer_[head].Dequeue();
+        Release(1);
         return true;
     }
 
-    template<typename T, std::size_t Capacity>
-    bool BatchedBoundedSPSCQueue<T, Capacity>::MoveHead(std::size_t& head) {
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t BatchSize, typename Counters>
+    template<typename... Args>
+    void BatchedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, BatchSize, Counters>::BlockingEmplace(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>) {
+        producer_wait_strategy_.Wait([&] { return Emplace(std::forward<Args>(args)...); });
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t BatchSize, typename Counters>
+    void BatchedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, BatchSize, Counters>::BlockingEnqueue(const T& element) noexcept(std::is_nothrow_copy_constructible_v<T>) {
+        BlockingEmplace(element);
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t BatchSize, typename Counters>
+    void BatchedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, BatchSize, Counters>::BlockingEnqueue(T&& element) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        BlockingEmplace(std::move(element));
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t BatchSize, typename Counters>
+    T* BatchedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, BatchSize, Counters>::BlockingFront() {
+        T* front = nullptr;
+        consumer_wait_strategy_.Wait([&] { return (front = Front()) != nullptr; });
+        return front;
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t BatchSize, typename Counters>
+    std::span<T> BatchedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, BatchSize, Counters>::Peek() {
+        Slot* slot = LoadHeadSlot();
+        return slot ? slot->Peek() : std::span<T>{};
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t BatchSize, typename Counters>
+    void BatchedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, BatchSize, Counters>::Release(std::size_t count) {
+        // The head slot can be unpublished, and the producer can be filling it
+        Slot* slot = count ? LoadHeadSlot() : nullptr;
+        if (!slot) {
+            return;
+        }
+        assert(count <= slot->Peek().size());
+
+        slot->Release(count);
+        if (slot->IsEmpty()) {
+            const std::size_t head = head_.load(std::memory_order_relaxed);
+            head_.store((head + 1) & GetIndexMask(), std::memory_order_release);
+            producer_wait_strategy_.Notify();
+        }
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t BatchSize, typename Counters>
+    typename BatchedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, BatchSize, Counters>::Slot* BatchedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, BatchSize, Counters>::LoadHeadSlot() {
+        const std::size_t head = head_.load(std::memory_order_acquire);
+
         if (head == cached_tail_) {
             cached_tail_ = tail_.load(std::memory_order_acquire);
+            counters_.Add(instrumentation::Event::kCachedTailRefresh);
             if (head == cached_tail_) {
-                return false;
+                return nullptr;
             }
         }
 
-        head = (head + 1) & GetIndexMask();
-        head_.store(head, std::memory_order_release);
-        return true;
+        return &buffer_[head];
     }
 
-    template<typename T, std::size_t Capacity>
-    bool BatchedBoundedSPSCQueue<T, Capacity>::IsEmptyConsumer() {
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t BatchSize, typename Counters>
+    bool BatchedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, BatchSize, Counters>::IsEmptyConsumer() {
         return !Front();
     }
 
-    template<typename T, std::size_t Capacity>
-    std::size_t BatchedBoundedSPSCQueue<T, Capacity>::GetCapacity() const noexcept {
-        return GetBufferSize();
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t BatchSize, typename Counters>
+    std::size_t BatchedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, BatchSize, Counters>::GetCapacity() const noexcept {
+        return (GetBufferSize() - 1) * BatchSize;
     }
 
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t BatchSize, typename Counters>
+    const Counters& BatchedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, BatchSize, Counters>::GetCounters() const noexcept {
+        return counters_;
+    }
 
-    template<typename T, std::size_t Capacity>
-    constexpr std::size_t BatchedBoundedSPSCQueue<T, Capacity>::GetBufferSize() {
-        std::size_t capacity = Capacity + 1;
-        if (capacity < 4) {
-            capacity = 4;
-        }
-
-        int max_bits_number = sizeof(std::size_t) * CHAR_BIT - 1;
-        capacity = 1 << (max_bits_number - __builtin_clzll(capacity) + 1);
-
-        assert((capacity & (capacity - 1)) == 0); // is power of two
 
-        return capacity;
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t BatchSize, typename Counters>
+    std::size_t BatchedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, BatchSize, Counters>::GetBufferSize() const noexcept {
+        return buffer_.GetSize();
     }
 
-    template<typename T, std::size_t Capacity>
-    constexpr std::size_t BatchedBoundedSPSCQueue<T, Capacity>::GetIndexMask() {
-        return GetBufferSize() - 1;
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t BatchSize, typename Counters>
+    std::size_t BatchedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, BatchSize, Counters>::GetIndexMask() const noexcept {
+        return buffer_.GetIndexMask();
     }
 
 
@@ -211,12 +354,32 @@ namespace concurrent::queue {
 
         template<typename T, std::size_t Size>
         void SPSCQueueSlot<T, Size>::Dequeue() {
+            DestroyElements(head_, head_ + 1);
             head_++;
         }
 
         template<typename T, std::size_t Size>
         T* SPSCQueueSlot<T, Size>::Front() {
-            return &buffer_[head_];
+            return GetElement(head_);
+        }
+
+        template<typename T, std::size_t Size>
+        std::span<T> SPSCQueueSlot<T, Size>::Peek() {
+            return {GetElement(head_), tail_ - head_};
+        }
+
+        template<typename T, std::size_t Size>
+        void SPSCQueueSlot<T, Size>::Release(std::size_t count) {
+            assert(head_ + count <= tail_);
+            DestroyElements(head_, head_ + count);
+            head_ += count;
+        }
+
+        template<typename T, std::size_t Size>
+        void SPSCQueueSlot<T, Size>::Clear() {
+            DestroyElements(head_, tail_);
+            head_ = 0;
+            tail_ = 0;
         }
 
         template<typename T, std::size_t Size>
@@ -229,6 +392,25 @@ namespace concurrent::queue {
             return tail_ == Size;
         }
 
+        template<typename T, std::size_t Size>
+        SPSCQueueSlot<T, Size>::~SPSCQueueSlot() {
+            DestroyElements(head_, tail_);
+        }
+
+        template<typename T, std::size_t Size>
+        T* SPSCQueueSlot<T, Size>::GetElement(std::size_t index) noexcept {
+            return std::launder(reinterpret_cast<T*>(&buffer_[index]));
+        }
+
+        template<typename T, std::size_t Size>
+        void SPSCQueueSlot<T, Size>::DestroyElements(std::size_t first, std::size_t last) noexcept {
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+                for (; first < last; ++first) {
+                    GetElement(first)->~T();
+                }
+            }
+        }
+
     }
 
 } // End of namespace concurrent::queue
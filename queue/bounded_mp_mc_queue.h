@@ -1,21 +1,49 @@
 #ifndef LOCK_FREE_BOUNDED_MP_MC_QUEUE_H
 #define LOCK_FREE_BOUNDED_MP_MC_QUEUE_H
 
-#include <array>
+#include <memory>
+#include <atomic>
 #include <cassert>
 #include <utility>
+#include <iterator>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
 #include <type_traits>
+#include <exception>
 
 #include "cache_line.h"
+#include "wait.h"
+#include "bounded_queue.h"
+#include "instrumentation.h"
 
 namespace concurrent::queue {
 
     using Generation = uint32_t;
 
+    // The number of the positions, which the token claims at once
+    inline constexpr std::size_t kDefaultTokenBlockSize = 16;
+
+    // kPadded puts every slot on its own cache line. kPacked stores the slots without padding, so several small slots
+    // share the line. The consecutive positions are mapped to the different lines, so the neighbour producers
+    // (consumers) do not write to the same line
+    enum class MPMCQueueSlotLayout {
+        kPadded,
+        kPacked
+    };
+
     namespace details {
 
-        template <typename T>
+        template <typename T, MPMCQueueSlotLayout Layout = MPMCQueueSlotLayout::kPadded>
         class MPMCQueueSlot {
+        private:
+            static constexpr std::size_t kAlignment = Layout == MPMCQueueSlotLayout::kPadded ?
+                    concurrent::cache::kCacheLineSize : alignof(std::atomic<Generation>);
+
         public:
             template<typename... Args, typename = std::enable_if_t<std::is_nothrow_constructible_v<T, Args...>, bool>>
             void Construct(Args&&... args) noexcept;
@@ -28,19 +56,71 @@ namespace concurrent::queue {
             Generation LoadGeneration(std::memory_order order = std::memory_order_acquire);
             void StoreGeneration(const Generation& new_generation, std::memory_order order = std::memory_order_release);
 
+            // Constructs the element and publishes the new generation
+            template<typename... Args, typename = std::enable_if_t<std::is_nothrow_constructible_v<T, Args...>, bool>>
+            void Write(Generation new_generation, Args&&... args) noexcept;
+
+            // Moves the element to the destination, destroys it and publishes the new generation
+            template<typename Destination>
+            void Read(Destination&& destination, Generation new_generation);
+
             ~MPMCQueueSlot();
 
         private:
-            alignas(concurrent::cache::kCacheLineSize) std::atomic<Generation> generation_{0};
+            alignas(kAlignment) std::atomic<Generation> generation_{0};
             std::aligned_storage_t<sizeof(T), alignof(T)> data_;
         };
 
+        // The slot of the element, which fits into 32 bits. The generation and the element are stored in one 64-bit word,
+        // so Write and Read publish the slot with one atomic store and the consumer gets the element
+        // from the same cache line access, which checks the generation
+        template <typename T, MPMCQueueSlotLayout Layout = MPMCQueueSlotLayout::kPadded>
+        class MPMCQueueWordSlot {
+        private:
+            using Word = std::uint64_t;
+            using Bits = std::uint32_t;
+
+            static constexpr std::size_t kGenerationShift = 32;
+            static constexpr std::size_t kAlignment = Layout == MPMCQueueSlotLayout::kPadded ?
+                    concurrent::cache::kCacheLineSize : alignof(std::atomic<Word>);
+
+        public:
+            Generation LoadGeneration(std::memory_order order = std::memory_order_acquire);
+            void StoreGeneration(const Generation& new_generation, std::memory_order order = std::memory_order_release);
+
+            template<typename... Args, typename = std::enable_if_t<std::is_nothrow_constructible_v<T, Args...>, bool>>
+            void Write(Generation new_generation, Args&&... args) noexcept;
+
+            template<typename Destination>
+            void Read(Destination&& destination, Generation new_generation);
+
+        private:
+            alignas(kAlignment) std::atomic<Word> word_{0};
+        };
+
+        template<typename T>
+        inline constexpr bool kIsWordSlotSupported = sizeof(T) <= sizeof(Generation) && std::is_trivially_copyable_v<T> &&
+                                                     std::atomic<std::uint64_t>::is_always_lock_free;
+
+        // MPMCQueueWordSlot for the small trivially copyable elements, MPMCQueueSlot for the others
+        template<typename T, MPMCQueueSlotLayout Layout>
+        using MPMCQueueSlotFor = std::conditional_t<kIsWordSlotSupported<T>, MPMCQueueWordSlot<T, Layout>, MPMCQueueSlot<T, Layout>>;
+
     }
 
-    template<typename T, std::size_t Capacity>
+    // Emplace, Enqueue and Dequeue wait for their slot with the WaitStrategy.
+    // The producer can skip its position (see ProducerToken) by moving the generation of the slot to the next lap
+    // without writing the element. The consumer, which finds the generation after the written one, takes the next position.
+    // Counters is the instrumentation policy. It counts the full and empty rejections of TryEnqueue and TryDequeue,
+    // the failed CAS of the indices and the checks of the generation, which was not ready, in Emplace and Dequeue
+    template<typename T, std::size_t Capacity = kDynamicCapacity, typename Allocator = std::allocator<T>,
+             typename WaitStrategy = wait::BusySpinWaitStrategy, MPMCQueueSlotLayout Layout = MPMCQueueSlotLayout::kPadded,
+             typename Counters = instrumentation::NoCounters>
     class BoundedMPMCQueue {
     public:
-        BoundedMPMCQueue() = default;
+        BoundedMPMCQueue() requires (Capacity != kDynamicCapacity);
+        explicit BoundedMPMCQueue(const Allocator& allocator) requires (Capacity != kDynamicCapacity);
+        explicit BoundedMPMCQueue(std::size_t capacity, const Allocator& allocator = Allocator()) requires (Capacity == kDynamicCapacity);
 
         BoundedMPMCQueue(const BoundedMPMCQueue&) = delete;
         BoundedMPMCQueue(BoundedMPMCQueue&&) = delete;
@@ -72,32 +152,185 @@ namespace concurrent::queue {
         template<typename = std::enable_if_t<std::is_copy_constructible_v<T> || std::is_move_constructible_v<T>, bool>>
         bool TryDequeue(T& element);
 
+        // Timed versions of TryEmplace, TryEnqueue and TryDequeue. They retry the CAS with the WaitStrategy until
+        // the operation succeeds or the deadline expires. The position is claimed only when its slot is ready,
+        // since the position taken with fetch_add must be served and cannot time out
+        template<typename Clock, typename Duration, typename... Args>
+        bool TryEmplaceUntil(const std::chrono::time_point<Clock, Duration>& deadline, Args&&... args) noexcept requires std::is_nothrow_constructible_v<T, Args...>;
+
+        template<typename Rep, typename Period, typename... Args>
+        bool TryEmplaceFor(const std::chrono::duration<Rep, Period>& timeout, Args&&... args) noexcept requires std::is_nothrow_constructible_v<T, Args...>;
+
+        template<typename Clock, typename Duration>
+        bool TryEnqueueUntil(const T& element, const std::chrono::time_point<Clock, Duration>& deadline) noexcept requires std::is_nothrow_copy_constructible_v<T>;
+
+        template<typename Clock, typename Duration>
+        bool TryEnqueueUntil(T&& element, const std::chrono::time_point<Clock, Duration>& deadline) noexcept requires std::is_nothrow_move_constructible_v<T>;
+
+        template<typename Rep, typename Period>
+        bool TryEnqueueFor(const T& element, const std::chrono::duration<Rep, Period>& timeout) noexcept requires std::is_nothrow_copy_constructible_v<T>;
+
+        template<typename Rep, typename Period>
+        bool TryEnqueueFor(T&& element, const std::chrono::duration<Rep, Period>& timeout) noexcept requires std::is_nothrow_move_constructible_v<T>;
+
+        template<typename Clock, typename Duration>
+        bool TryDequeueUntil(T& element, const std::chrono::time_point<Clock, Duration>& deadline);
+
+        template<typename Rep, typename Period>
+        bool TryDequeueFor(T& element, const std::chrono::duration<Rep, Period>& timeout);
+
+        // Claims the slots for all elements of [first, last) with one fetch_add and fills them in order
+        template<std::forward_iterator InputIt>
+        void EnqueueBulk(InputIt first, InputIt last) noexcept requires std::is_nothrow_copy_constructible_v<T>;
+
+        // Claims with one CAS as many free slots as there are in a row for the elements of [first, last).
+        // Returns the number of enqueued elements
+        template<std::forward_iterator InputIt>
+        std::size_t TryEnqueueBulk(InputIt first, InputIt last) noexcept requires std::is_nothrow_copy_constructible_v<T>;
+
+        // Claims count slots with one fetch_add and drains them to out in order
+        template<typename OutputIt>
+        void DequeueBulk(OutputIt out, std::size_t count);
+
+        // Claims with one CAS up to max_count written slots in a row. Returns the number of dequeued elements,
+        // which is 0 only if the queue is empty. The claim, which has only the skipped positions, is retried
+        template<typename OutputIt>
+        std::size_t TryDequeueBulk(OutputIt out, std::size_t max_count);
+
 
         [[nodiscard]] std::size_t GetSize() const noexcept;
         [[nodiscard]] bool IsEmpty() const noexcept;
         [[nodiscard]] std::size_t GetCapacity() const noexcept;
 
+        [[nodiscard]] const Counters& GetCounters() const noexcept;
+
         ~BoundedMPMCQueue() = default;
 
+        // Claims the block of block_size positions with one fetch_add of tail_ and fills them in order.
+        // The consumers of the claimed positions wait until the token fills them, so the token, which stops producing,
+        // must be flushed. Flush (and the destructor) skips the positions, which are left in the block
+        class ProducerToken {
+        private:
+            using Queue = BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>;
+
+        public:
+            explicit ProducerToken(Queue* queue, std::size_t block_size = kDefaultTokenBlockSize);
+
+            ProducerToken(const ProducerToken&) = delete;
+            ProducerToken(ProducerToken&&) = delete;
+            ProducerToken& operator=(const ProducerToken&) = delete;
+            ProducerToken& operator=(ProducerToken&&) = delete;
+
+            template<typename... Args, typename = std::enable_if_t<std::is_nothrow_constructible_v<T, Args...>, bool>>
+            void Emplace(Args&&... args) noexcept;
+
+            template<typename = std::enable_if_t<std::is_nothrow_copy_constructible_v<T>, bool>>
+            void Enqueue(const T& element) noexcept;
+
+            template<typename = std::enable_if_t<std::is_nothrow_move_constructible_v<T>, bool>>
+            void Enqueue(T&& element) noexcept;
+
+            // Skips the positions, which are left in the block. Waits for their slots to be free
+            void Flush() noexcept;
+
+            ~ProducerToken();
+
+        private:
+            Queue* queue_;
+            std::size_t block_size_;
+            std::size_t next_{0};
+            std::size_t end_{0};
+        };
+
+        // Claims with one CAS of head_ up to block_size written positions in a row and reads them one by one.
+        // The other consumers cannot take the claimed elements, so the token must be drained before it is destroyed.
+        // Like std::thread, the token calls std::terminate if it is not, since the slots of the claimed elements
+        // would stay written and the producers of the next lap would wait for them forever
+        class ConsumerToken {
+        private:
+            using Queue = BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>;
+
+        public:
+            explicit ConsumerToken(Queue* queue, std::size_t block_size = kDefaultTokenBlockSize);
+
+            ConsumerToken(const ConsumerToken&) = delete;
+            ConsumerToken(ConsumerToken&&) = delete;
+            ConsumerToken& operator=(const ConsumerToken&) = delete;
+            ConsumerToken& operator=(ConsumerToken&&) = delete;
+
+            template<typename = std::enable_if_t<std::is_copy_constructible_v<T> || std::is_move_constructible_v<T>, bool>>
+            void Dequeue(T& element);
+
+            template<typename = std::enable_if_t<std::is_copy_constructible_v<T> || std::is_move_constructible_v<T>, bool>>
+            bool TryDequeue(T& element);
+
+            // Reads the claimed elements, which are not dequeued yet, to out in order. Does not claim the new ones.
+            // Returns the number of read elements. The skipped positions of the block are passed, but not counted,
+            // so 0 means that the token holds no more elements, not that the queue is empty
+            template<typename OutputIt>
+            std::size_t Drain(OutputIt out);
+
+            [[nodiscard]] bool IsDrained() const noexcept;
+
+            // Calls std::terminate if the token is not drained
+            ~ConsumerToken();
+
+        private:
+            bool ClaimBlock();
+
+            Queue* queue_;
+            std::size_t block_size_;
+            std::size_t next_{0};
+            std::size_t end_{0};
+        };
+
+        friend class ProducerToken;
+        friend class ConsumerToken;
+
     private:
-        std::size_t GetIndex(std::size_t i);
-        Generation GetGeneration(std::size_t i);
+        using Slot = details::MPMCQueueSlotFor<T, Layout>;
+        using SlotAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Slot>;
+        using Buffer = details::RingBuffer<Slot, Capacity == kDynamicCapacity ? kDynamicCapacity : details::GetBufferSize(Capacity), SlotAllocator>;
 
-        static constexpr std::size_t GetBufferSize();
-        static constexpr std::size_t GetIndexMask();
-        static constexpr std::size_t GetGenerationMask();
+        // log2 of the number of the slots in one cache line
+        static constexpr std::size_t kSlotsPerLineShift = Layout == MPMCQueueSlotLayout::kPacked && sizeof(Slot) < concurrent::cache::kCacheLineSize ?
+                std::countr_zero(std::bit_floor(concurrent::cache::kCacheLineSize / sizeof(Slot))) : 0;
+
+        // Maps the position to the slot. If the slots are packed, the low bits of the position select the line
+        // and the high bits select the slot in the line
+        std::size_t GetIndex(std::size_t i) const noexcept;
+        Generation GetGeneration(std::size_t i) const noexcept;
+
+        // The generation of the slot, when it is free for the position i (for the producer) or written (for the consumer)
+        Generation GetFreeGeneration(std::size_t i) const noexcept;
+        Generation GetWrittenGeneration(std::size_t i) const noexcept;
+
+        // The generation of the slot is after the written one for the position i, so the producer skipped the position
+        bool IsSkipped(Generation slot_generation, std::size_t i) const noexcept;
+
+        // Reads the element of the written slot for the position i and frees the slot
+        void Read(std::size_t i, T& element);
+
+        // The number of slots in a row starting from the position, for which is_ready(i, slot_generation) is true
+        template<typename IsReady>
+        std::size_t GetReadySlotsCount(std::size_t position, std::size_t max_count, IsReady&& is_ready);
+
+        std::size_t GetBufferSize() const noexcept;
 
     private:
         PADDING(padding0_, 0);
 
-        std::array<details::MPMCQueueSlot<T>, GetBufferSize()> buffer_;
+        Buffer buffer_;
 
-        PADDING(padding1_, 0);
+        PADDING(padding1_, sizeof(Buffer));
 
         alignas(concurrent::cache::kCacheLineSize) std::atomic<std::size_t> head_{0};
         alignas(concurrent::cache::kCacheLineSize) std::atomic<std::size_t> tail_{0};
 
         PADDING(padding2_, 0);
+
+        [[no_unique_address]] WaitStrategy wait_strategy_; // Producers and consumers wait on it for the generation of their slot
+        [[no_unique_address]] Counters counters_;
     };
 
 
@@ -105,72 +338,140 @@ namespace concurrent::queue {
 
     namespace details {
 
-        template<typename T>
+        template<typename T, MPMCQueueSlotLayout Layout>
         template<typename... Args, typename>
-        void MPMCQueueSlot<T>::Construct(Args&&... args) noexcept {
+        void MPMCQueueSlot<T, Layout>::Construct(Args&&... args) noexcept {
             new (&data_) T(std::forward<Args>(args)...);
         }
 
-        template<typename T>
-        T&& MPMCQueueSlot<T>::Move() noexcept {
+        template<typename T, MPMCQueueSlotLayout Layout>
+        T&& MPMCQueueSlot<T, Layout>::Move() noexcept {
             return std::move((*reinterpret_cast<T*>(&data_)));
         }
 
-        template<typename T>
+        template<typename T, MPMCQueueSlotLayout Layout>
         template<typename>
-        void MPMCQueueSlot<T>::Destroy() noexcept {
+        void MPMCQueueSlot<T, Layout>::Destroy() noexcept {
             reinterpret_cast<T*>(&data_)->~T();
         }
 
-        template<typename T>
-        Generation MPMCQueueSlot<T>::LoadGeneration(std::memory_order order) {
+        template<typename T, MPMCQueueSlotLayout Layout>
+        Generation MPMCQueueSlot<T, Layout>::LoadGeneration(std::memory_order order) {
             return generation_.load(order);
         }
 
-        template<typename T>
-        void MPMCQueueSlot<T>::StoreGeneration(const Generation& new_generation, std::memory_order order) {
+        template<typename T, MPMCQueueSlotLayout Layout>
+        void MPMCQueueSlot<T, Layout>::StoreGeneration(const Generation& new_generation, std::memory_order order) {
             return generation_.store(new_generation, order);
         }
 
-        template<typename T>
-        MPMCQueueSlot<T>::~MPMCQueueSlot() {
+        template<typename T, MPMCQueueSlotLayout Layout>
+        template<typename... Args, typename>
+        void MPMCQueueSlot<T, Layout>::Write(Generation new_generation, Args&&... args) noexcept {
+            Construct(std::forward<Args>(args)...);
+            StoreGeneration(new_generation);
+        }
+
+        template<typename T, MPMCQueueSlotLayout Layout>
+        template<typename Destination>
+        void MPMCQueueSlot<T, Layout>::Read(Destination&& destination, Generation new_generation) {
+            std::forward<Destination>(destination) = Move();
+            Destroy();
+            StoreGeneration(new_generation);
+        }
+
+        template<typename T, MPMCQueueSlotLayout Layout>
+        MPMCQueueSlot<T, Layout>::~MPMCQueueSlot() {
             if (generation_.load() & 1) {
                 Destroy();
             }
         }
 
+
+        template<typename T, MPMCQueueSlotLayout Layout>
+        Generation MPMCQueueWordSlot<T, Layout>::LoadGeneration(std::memory_order order) {
+            return static_cast<Generation>(word_.load(order) >> kGenerationShift);
+        }
+
+        template<typename T, MPMCQueueSlotLayout Layout>
+        void MPMCQueueWordSlot<T, Layout>::StoreGeneration(const Generation& new_generation, std::memory_order order) {
+            word_.store(static_cast<Word>(new_generation) << kGenerationShift, order);
+        }
+
+        template<typename T, MPMCQueueSlotLayout Layout>
+        template<typename... Args, typename>
+        void MPMCQueueWordSlot<T, Layout>::Write(Generation new_generation, Args&&... args) noexcept {
+            const T element(std::forward<Args>(args)...);
+
+            Bits bits = 0;
+            std::memcpy(&bits, &element, sizeof(T));
+            word_.store((static_cast<Word>(new_generation) << kGenerationShift) | bits, std::memory_order_release);
+        }
+
+        template<typename T, MPMCQueueSlotLayout Layout>
+        template<typename Destination>
+        void MPMCQueueWordSlot<T, Layout>::Read(Destination&& destination, Generation new_generation) {
+            // The consumer has already loaded the written generation with acquire, and only it changes the slot now
+            const auto bits = static_cast<Bits>(word_.load(std::memory_order_relaxed));
+
+            std::array<std::byte, sizeof(T)> bytes;
+            std::memcpy(bytes.data(), &bits, sizeof(T));
+            std::forward<Destination>(destination) = std::bit_cast<T>(bytes);
+
+            StoreGeneration(new_generation);
+        }
+
     }
 
-    template<typename T, std::size_t Capacity>
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::BoundedMPMCQueue() requires (Capacity != kDynamicCapacity) : BoundedMPMCQueue(Allocator()) {}
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::BoundedMPMCQueue(const Allocator& allocator) requires (Capacity != kDynamicCapacity)
+            : buffer_(SlotAllocator(allocator)) {}
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::BoundedMPMCQueue(std::size_t capacity, const Allocator& allocator) requires (Capacity == kDynamicCapacity)
+            : buffer_(details::GetBufferSize(capacity), SlotAllocator(allocator)) {}
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
     template<typename... Args, typename>
-    void BoundedMPMCQueue<T, Capacity>::Emplace(Args&&... args) noexcept {
+    void BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::Emplace(Args&&... args) noexcept {
         const std::size_t tail = tail_.fetch_add(1);
 
         const std::size_t index = GetIndex(tail);
         const Generation generation = 2 * GetGeneration(tail);
 
-        while (generation != buffer_[index].LoadGeneration());
+        wait_strategy_.Wait([&] {
+            if (generation == buffer_[index].LoadGeneration()) {
+                return true;
+            }
+            counters_.Add(instrumentation::Event::kGenerationSpin);
+            return false;
+        });
 
-        buffer_[index].Construct(std::forward<Args>(args)...);
-        buffer_[index].StoreGeneration(generation + 1);
+        buffer_[index].Write(generation + 1, std::forward<Args>(args)...);
+        wait_strategy_.Notify();
     }
 
-    template<typename T, std::size_t Capacity>
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
     template<typename... Args, typename>
-    bool BoundedMPMCQueue<T, Capacity>::TryEmplace(Args&&... args) noexcept {
+    bool BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::TryEmplace(Args&&... args) noexcept {
         std::size_t tail = tail_.load(std::memory_order_acquire);
         while (true) {
             const std::size_t index = GetIndex(tail);
             const Generation generation = 2 * GetGeneration(tail);
             if (generation == buffer_[index].LoadGeneration()) {
                 if (tail_.compare_exchange_weak(tail, tail + 1)) {
-                    buffer_[index].Construct(std::forward<Args>(args)...);
-                    buffer_[index].StoreGeneration(generation + 1);
+                    buffer_[index].Write(generation + 1, std::forward<Args>(args)...);
+                    wait_strategy_.Notify();
                     return true;
                 }
+                counters_.Add(instrumentation::Event::kCasRetry);
             } else {
                 const std::size_t new_tail = tail_.load(std::memory_order_acquire);
                 if (tail == new_tail) {
+                    counters_.Add(instrumentation::Event::kFullRejection);
                     return false;
                 }
                 tail = new_tail;
@@ -178,64 +479,79 @@ namespace concurrent::queue {
         }
     }
 
-    template<typename T, std::size_t Capacity>
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
     template<typename>
-    void BoundedMPMCQueue<T, Capacity>::Enqueue(const T& element) noexcept {
+    void BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::Enqueue(const T& element) noexcept {
         Emplace(element);
     }
 
-    template<typename T, std::size_t Capacity>
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
     template<typename>
-    bool BoundedMPMCQueue<T, Capacity>::TryEnqueue(const T& element) noexcept {
+    bool BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::TryEnqueue(const T& element) noexcept {
         return TryEmplace(element);
     }
 
-    template<typename T, std::size_t Capacity>
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
     template<typename>
-    void BoundedMPMCQueue<T, Capacity>::Enqueue(T&& element) noexcept {
+    void BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::Enqueue(T&& element) noexcept {
         Emplace(std::forward<T>(element));
     }
 
-    template<typename T, std::size_t Capacity>
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
     template<typename>
-    bool BoundedMPMCQueue<T, Capacity>::TryEnqueue(T&& element) noexcept {
+    bool BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::TryEnqueue(T&& element) noexcept {
         return TryEmplace(std::forward<T>(element));
     }
 
 
-    template<typename T, std::size_t Capacity>
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
     template<typename>
-    void BoundedMPMCQueue<T, Capacity>::Dequeue(T& element) {
-        const std::size_t head = head_.fetch_add(1);
-
-        const std::size_t index = GetIndex(head);
-        const Generation generation = 2 * GetGeneration(head) + 1;
+    void BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::Dequeue(T& element) {
+        while (true) {
+            const std::size_t head = head_.fetch_add(1);
 
-        while (generation != buffer_[index].LoadGeneration());
+            const std::size_t index = GetIndex(head);
+            const Generation generation = 2 * GetGeneration(head) + 1;
 
-        element = buffer_[index].Move();
+            Generation slot_generation;
+            wait_strategy_.Wait([&] {
+                slot_generation = buffer_[index].LoadGeneration();
+                if (generation == slot_generation || IsSkipped(slot_generation, head)) {
+                    return true;
+                }
+                counters_.Add(instrumentation::Event::kGenerationSpin);
+                return false;
+            });
 
-        buffer_[index].Destroy();
-        buffer_[index].StoreGeneration(generation + 1);
+            if (generation == slot_generation) {
+                Read(head, element);
+                return;
+            }
+        }
     }
 
-    template<typename T, std::size_t Capacity>
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
     template<typename>
-    bool BoundedMPMCQueue<T, Capacity>::TryDequeue(T& element) {
+    bool BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::TryDequeue(T& element) {
         std::size_t head = head_.load(std::memory_order_acquire);
         while (true) {
             const std::size_t index = GetIndex(head);
             const Generation generation = 2 * GetGeneration(head) + 1;
-            if (generation == buffer_[index].LoadGeneration()) {
+            const Generation slot_generation = buffer_[index].LoadGeneration();
+            if (generation == slot_generation) {
                 if (head_.compare_exchange_weak(head, head + 1)) {
-                    element = buffer_[index].Move();
-                    buffer_[index].Destroy();
-                    buffer_[index].StoreGeneration(generation + 1);
+                    Read(head, element);
                     return true;
                 }
+                counters_.Add(instrumentation::Event::kCasRetry);
+            } else if (IsSkipped(slot_generation, head)) {
+                if (head_.compare_exchange_weak(head, head + 1)) {
+                    ++head;
+                }
             } else {
                 const std::size_t new_head = head_.load(std::memory_order_acquire);
                 if (new_head == head) {
+                    counters_.Add(instrumentation::Event::kEmptyRejection);
                     return false;
                 }
                 head = new_head;
@@ -243,55 +559,403 @@ namespace concurrent::queue {
         }
     }
 
-    template<typename T, std::size_t Capacity>
-    std::size_t BoundedMPMCQueue<T, Capacity>::GetSize() const noexcept {
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    template<typename Clock, typename Duration, typename... Args>
+    bool BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::TryEmplaceUntil(const std::chrono::time_point<Clock, Duration>& deadline,
+                                                                                       Args&&... args) noexcept requires std::is_nothrow_constructible_v<T, Args...> {
+        // TryEmplace uses the arguments only if it succeeds, so they can be forwarded on every attempt
+        return wait_strategy_.WaitUntil([&] { return TryEmplace(std::forward<Args>(args)...); }, deadline);
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    template<typename Rep, typename Period, typename... Args>
+    bool BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::TryEmplaceFor(const std::chrono::duration<Rep, Period>& timeout,
+                                                                                     Args&&... args) noexcept requires std::is_nothrow_constructible_v<T, Args...> {
+        return TryEmplaceUntil(std::chrono::steady_clock::now() + timeout, std::forward<Args>(args)...);
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    template<typename Clock, typename Duration>
+    bool BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::TryEnqueueUntil(const T& element, const std::chrono::time_point<Clock, Duration>& deadline) noexcept
+            requires std::is_nothrow_copy_constructible_v<T> {
+        return TryEmplaceUntil(deadline, element);
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    template<typename Clock, typename Duration>
+    bool BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::TryEnqueueUntil(T&& element, const std::chrono::time_point<Clock, Duration>& deadline) noexcept
+            requires std::is_nothrow_move_constructible_v<T> {
+        return TryEmplaceUntil(deadline, std::move(element));
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    template<typename Rep, typename Period>
+    bool BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::TryEnqueueFor(const T& element, const std::chrono::duration<Rep, Period>& timeout) noexcept
+            requires std::is_nothrow_copy_constructible_v<T> {
+        return TryEmplaceFor(timeout, element);
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    template<typename Rep, typename Period>
+    bool BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::TryEnqueueFor(T&& element, const std::chrono::duration<Rep, Period>& timeout) noexcept
+            requires std::is_nothrow_move_constructible_v<T> {
+        return TryEmplaceFor(timeout, std::move(element));
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    template<typename Clock, typename Duration>
+    bool BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::TryDequeueUntil(T& element, const std::chrono::time_point<Clock, Duration>& deadline) {
+        return wait_strategy_.WaitUntil([&] { return TryDequeue(element); }, deadline);
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    template<typename Rep, typename Period>
+    bool BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::TryDequeueFor(T& element, const std::chrono::duration<Rep, Period>& timeout) {
+        return TryDequeueUntil(element, std::chrono::steady_clock::now() + timeout);
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    template<std::forward_iterator InputIt>
+    void BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::EnqueueBulk(InputIt first, InputIt last) noexcept requires std::is_nothrow_copy_constructible_v<T> {
+        const auto count = static_cast<std::size_t>(std::distance(first, last));
+        if (!count) {
+            return;
+        }
+
+        const std::size_t tail = tail_.fetch_add(count);
+
+        for (std::size_t i = tail; first != last; ++i, ++first) {
+            const std::size_t index = GetIndex(i);
+            const Generation generation = GetFreeGeneration(i);
+
+            wait_strategy_.Wait([&] { return generation == buffer_[index].LoadGeneration(); });
+
+            buffer_[index].Write(generation + 1, *first);
+            wait_strategy_.Notify(); // The consumers of the written slots must not wait for the whole range
+        }
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    template<std::forward_iterator InputIt>
+    std::size_t BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::TryEnqueueBulk(InputIt first, InputIt last) noexcept requires std::is_nothrow_copy_constructible_v<T> {
+        const auto max_count = static_cast<std::size_t>(std::distance(first, last));
+
+        std::size_t tail = tail_.load(std::memory_order_acquire);
+        std::size_t count = 0;
+        while (true) {
+            // The free slots stay free until the producer, which claimed them, writes them
+            count = GetReadySlotsCount(tail, max_count, [this](std::size_t i, Generation slot_generation) {
+                return GetFreeGeneration(i) == slot_generation;
+            });
+            if (count) {
+                if (tail_.compare_exchange_weak(tail, tail + count)) {
+                    break;
+                }
+            } else {
+                const std::size_t new_tail = tail_.load(std::memory_order_acquire);
+                if (tail == new_tail) {
+                    return 0;
+                }
+                tail = new_tail;
+            }
+        }
+
+        for (std::size_t i = tail; i < tail + count; ++i, ++first) {
+            buffer_[GetIndex(i)].Write(GetFreeGeneration(i) + 1, *first);
+        }
+        wait_strategy_.Notify();
+
+        return count;
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    template<typename OutputIt>
+    void BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::DequeueBulk(OutputIt out, std::size_t count) {
+        if (!count) {
+            return;
+        }
+
+        // The skipped positions are replaced with the positions claimed after the range
+        while (count) {
+            const std::size_t head = head_.fetch_add(count);
+            const std::size_t end = head + count;
+
+            for (std::size_t i = head; i < end; ++i) {
+                const std::size_t index = GetIndex(i);
+                const Generation generation = GetWrittenGeneration(i);
+
+                Generation slot_generation;
+                wait_strategy_.Wait([&] {
+                    slot_generation = buffer_[index].LoadGeneration();
+                    return generation == slot_generation || IsSkipped(slot_generation, i);
+                });
+
+                if (generation == slot_generation) {
+                    Read(i, *out);
+                    ++out;
+                    --count;
+                }
+            }
+        }
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    template<typename OutputIt>
+    std::size_t BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::TryDequeueBulk(OutputIt out, std::size_t max_count) {
+        std::size_t head = head_.load(std::memory_order_acquire);
+        while (true) {
+            std::size_t count = 0;
+            while (true) {
+                count = GetReadySlotsCount(head, max_count, [this](std::size_t i, Generation slot_generation) {
+                    return GetWrittenGeneration(i) == slot_generation || IsSkipped(slot_generation, i);
+                });
+                if (count) {
+                    if (head_.compare_exchange_weak(head, head + count)) {
+                        break;
+                    }
+                } else {
+                    const std::size_t new_head = head_.load(std::memory_order_acquire);
+                    if (head == new_head) {
+                        return 0;
+                    }
+                    head = new_head;
+                }
+            }
+
+            // The skipped positions are claimed, but not counted
+            std::size_t read_count = 0;
+            for (std::size_t i = head; i < head + count; ++i) {
+                const std::size_t index = GetIndex(i);
+                if (GetWrittenGeneration(i) == buffer_[index].LoadGeneration()) {
+                    buffer_[index].Read(*out, GetWrittenGeneration(i) + 1);
+                    ++out;
+                    ++read_count;
+                }
+            }
+            wait_strategy_.Notify();
+
+            if (read_count) {
+                return read_count;
+            }
+
+            // Only the skipped positions were claimed. The written elements can follow them, so 0 would not mean empty
+            head = head_.load(std::memory_order_acquire);
+        }
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    std::size_t BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::GetSize() const noexcept {
         return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
     }
 
-    template<typename T, std::size_t Capacity>
-    bool BoundedMPMCQueue<T, Capacity>::IsEmpty() const noexcept {
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    bool BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::IsEmpty() const noexcept {
         return GetSize() == 0;
     }
 
-    template<typename T, std::size_t Capacity>
-    std::size_t BoundedMPMCQueue<T, Capacity>::GetCapacity() const noexcept {
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    std::size_t BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::GetCapacity() const noexcept {
         return GetBufferSize();
     }
 
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    const Counters& BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::GetCounters() const noexcept {
+        return counters_;
+    }
+
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    std::size_t BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::GetIndex(std::size_t i) const noexcept {
+        const std::size_t position = i & buffer_.GetIndexMask();
+        if constexpr (kSlotsPerLineShift == 0) {
+            return position;
+        } else {
+            const std::size_t slots_shift = std::min(kSlotsPerLineShift, buffer_.GetIndexShift());
+            const std::size_t lines_shift = buffer_.GetIndexShift() - slots_shift;
+            return ((position & ((std::size_t{1} << lines_shift) - 1)) << slots_shift) | (position >> lines_shift);
+        }
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    Generation BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::GetGeneration(std::size_t i) const noexcept {
+        return static_cast<Generation>(i >> buffer_.GetIndexShift());
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    Generation BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::GetFreeGeneration(std::size_t i) const noexcept {
+        return 2 * GetGeneration(i);
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    Generation BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::GetWrittenGeneration(std::size_t i) const noexcept {
+        return 2 * GetGeneration(i) + 1;
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    bool BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::IsSkipped(Generation slot_generation, std::size_t i) const noexcept {
+        // The generations are compared as the serial numbers, so the comparison is correct after the overflow
+        return static_cast<std::int32_t>(slot_generation - GetWrittenGeneration(i)) > 0;
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    void BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::Read(std::size_t i, T& element) {
+        buffer_[GetIndex(i)].Read(element, GetWrittenGeneration(i) + 1);
+        wait_strategy_.Notify();
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    template<typename IsReady>
+    std::size_t BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::GetReadySlotsCount(std::size_t position, std::size_t max_count,
+                                                                                         IsReady&& is_ready) {
+        std::size_t count = 0;
+        while (count < max_count && is_ready(position + count, buffer_[GetIndex(position + count)].LoadGeneration())) {
+            ++count;
+        }
+        return count;
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    std::size_t BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::GetBufferSize() const noexcept {
+        return buffer_.GetSize();
+    }
+
+    // ProducerToken
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::ProducerToken::ProducerToken(Queue* queue, std::size_t block_size)
+            : queue_(queue), block_size_(std::clamp<std::size_t>(block_size, 1, queue->GetCapacity())) {}
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    template<typename... Args, typename>
+    void BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::ProducerToken::Emplace(Args&&... args) noexcept {
+        if (next_ == end_) {
+            next_ = queue_->tail_.fetch_add(block_size_);
+            end_ = next_ + block_size_;
+        }
+
+        const std::size_t tail = next_++;
+        const std::size_t index = queue_->GetIndex(tail);
+        const Generation generation = queue_->GetFreeGeneration(tail);
+
+        queue_->wait_strategy_.Wait([&] { return generation == queue_->buffer_[index].LoadGeneration(); });
+
+        queue_->buffer_[index].Write(generation + 1, std::forward<Args>(args)...);
+        queue_->wait_strategy_.Notify();
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    template<typename>
+    void BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::ProducerToken::Enqueue(const T& element) noexcept {
+        Emplace(element);
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    template<typename>
+    void BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::ProducerToken::Enqueue(T&& element) noexcept {
+        Emplace(std::forward<T>(element));
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    void BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::ProducerToken::Flush() noexcept {
+        for (; next_ < end_; ++next_) {
+            const std::size_t index = queue_->GetIndex(next_);
+            const Generation generation = queue_->GetFreeGeneration(next_);
 
-    template<typename T, std::size_t Capacity>
-    std::size_t BoundedMPMCQueue<T, Capacity>::GetIndex(std::size_t i) {
-        return i & GetIndexMask();
+            queue_->wait_strategy_.Wait([&] { return generation == queue_->buffer_[index].LoadGeneration(); });
+
+            // The free generation of the next lap. The consumer of the position sees it after the written one
+            queue_->buffer_[index].StoreGeneration(generation + 2);
+        }
+        queue_->wait_strategy_.Notify();
     }
 
-    template<typename T, std::size_t Capacity>
-    Generation BoundedMPMCQueue<T, Capacity>::GetGeneration(std::size_t i) {
-        return i & GetGenerationMask();
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::ProducerToken::~ProducerToken() {
+        Flush();
     }
 
-    template<typename T, std::size_t Capacity>
-    constexpr std::size_t BoundedMPMCQueue<T, Capacity>::GetBufferSize() {
-        std::size_t capacity = Capacity + 1;
-        if (capacity < 4) {
-            capacity = 4;
+
+    // ConsumerToken
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::ConsumerToken::ConsumerToken(Queue* queue, std::size_t block_size)
+            : queue_(queue), block_size_(std::clamp<std::size_t>(block_size, 1, queue->GetCapacity())) {}
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    template<typename>
+    void BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::ConsumerToken::Dequeue(T& element) {
+        queue_->wait_strategy_.Wait([&] { return TryDequeue(element); });
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    template<typename>
+    bool BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::ConsumerToken::TryDequeue(T& element) {
+        while (true) {
+            // The claimed slots stay written (skipped) until the token reads them
+            while (next_ < end_) {
+                const std::size_t head = next_++;
+                if (queue_->GetWrittenGeneration(head) == queue_->buffer_[queue_->GetIndex(head)].LoadGeneration()) {
+                    queue_->Read(head, element);
+                    return true;
+                }
+            }
+
+            if (!ClaimBlock()) {
+                return false;
+            }
         }
+    }
 
-        int max_bits_number = sizeof(std::size_t) * CHAR_BIT - 1;
-        capacity = 1 << (max_bits_number - __builtin_clzll(capacity) + 1);
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    template<typename OutputIt>
+    std::size_t BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::ConsumerToken::Drain(OutputIt out) {
+        // The skipped positions are passed, but not counted
+        std::size_t read_count = 0;
+        for (; next_ < end_; ++next_) {
+            const std::size_t index = queue_->GetIndex(next_);
+            if (queue_->GetWrittenGeneration(next_) == queue_->buffer_[index].LoadGeneration()) {
+                queue_->buffer_[index].Read(*out, queue_->GetWrittenGeneration(next_) + 1);
+                ++out;
+                ++read_count;
+            }
+        }
+        queue_->wait_strategy_.Notify();
 
-        assert((capacity & (capacity - 1)) == 0); // is power of two
+        return read_count;
+    }
 
-        return capacity;
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    bool BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::ConsumerToken::IsDrained() const noexcept {
+        return next_ == end_;
     }
 
-    template<typename T, std::size_t Capacity>
-    constexpr std::size_t BoundedMPMCQueue<T, Capacity>::GetIndexMask() {
-        return GetBufferSize() - 1;
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::ConsumerToken::~ConsumerToken() {
+        // Enqueueing the claimed elements back would break FIFO and could wait for the slot, which the token still holds
+        if (!IsDrained()) {
+            std::terminate();
+        }
     }
 
-    template<typename T, std::size_t Capacity>
-    constexpr std::size_t BoundedMPMCQueue<T, Capacity>::GetGenerationMask() {
-        return ~GetIndexMask();
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, MPMCQueueSlotLayout Layout, typename Counters>
+    bool BoundedMPMCQueue<T, Capacity, Allocator, WaitStrategy, Layout, Counters>::ConsumerToken::ClaimBlock() {
+        std::size_t head = queue_->head_.load(std::memory_order_acquire);
+        while (true) {
+            const std::size_t count = queue_->GetReadySlotsCount(head, block_size_, [this](std::size_t i, Generation slot_generation) {
+                return queue_->GetWrittenGeneration(i) == slot_generation || queue_->IsSkipped(slot_generation, i);
+            });
+            if (count) {
+                if (queue_->head_.compare_exchange_weak(head, head + count)) {
+                    next_ = head;
+                    end_ = head + count;
+                    return true;
+                }
+            } else {
+                const std::size_t new_head = queue_->head_.load(std::memory_order_acquire);
+                if (head == new_head) {
+                    return false;
+                }
+                head = new_head;
+            }
+        }
     }
 
 } //End of namespace concurrent::queue
@@ -0,0 +1,233 @@
+#ifndef LOCK_FREE_BOUNDED_MP_SC_QUEUE_H
+#define LOCK_FREE_BOUNDED_MP_SC_QUEUE_H
+
+#include <memory>
+#include <atomic>
+#include <utility>
+#include <type_traits>
+
+#include "cache_line.h"
+#include "wait.h"
+#include "bounded_queue.h"
+#include "bounded_mp_mc_queue.h"
+
+namespace concurrent::queue {
+
+    // BoundedMPMCQueue with the single consumer. The producers claim the positions with fetch_add (CAS in TryEmplace)
+    // and wait for the generation of their slot in the same way. The consumer owns head_: it checks the generation
+    // of the next slot and moves head_ with a plain store, so it never executes the atomic RMW operations
+    template<typename T, std::size_t Capacity = kDynamicCapacity, typename Allocator = std::allocator<T>,
+             typename WaitStrategy = wait::BusySpinWaitStrategy>
+    class BoundedMPSCQueue {
+    public:
+        BoundedMPSCQueue() requires (Capacity != kDynamicCapacity);
+        explicit BoundedMPSCQueue(const Allocator& allocator) requires (Capacity != kDynamicCapacity);
+        explicit BoundedMPSCQueue(std::size_t capacity, const Allocator& allocator = Allocator()) requires (Capacity == kDynamicCapacity);
+
+        BoundedMPSCQueue(const BoundedMPSCQueue&) = delete;
+        BoundedMPSCQueue(BoundedMPSCQueue&&) = delete;
+        BoundedMPSCQueue& operator=(const BoundedMPSCQueue&) = delete;
+        BoundedMPSCQueue& operator=(BoundedMPSCQueue&&) = delete;
+
+        // Producer methods
+        template<typename... Args, typename = std::enable_if_t<std::is_nothrow_constructible_v<T, Args...>, bool>>
+        void Emplace(Args&&... args) noexcept;
+
+        template<typename... Args, typename = std::enable_if_t<std::is_nothrow_constructible_v<T, Args...>, bool>>
+        bool TryEmplace(Args&&... args) noexcept;
+
+        template<typename = std::enable_if_t<std::is_nothrow_copy_constructible_v<T>, bool>>
+        void Enqueue(const T& element) noexcept;
+
+        template<typename = std::enable_if_t<std::is_nothrow_copy_constructible_v<T>, bool>>
+        bool TryEnqueue(const T& element) noexcept;
+
+        template<typename = std::enable_if_t<std::is_nothrow_move_constructible_v<T>, bool>>
+        void Enqueue(T&& element) noexcept;
+
+        template<typename = std::enable_if_t<std::is_nothrow_move_constructible_v<T>, bool>>
+        bool TryEnqueue(T&& element) noexcept;
+
+        // Consumer methods
+        template<typename = std::enable_if_t<std::is_copy_constructible_v<T> || std::is_move_constructible_v<T>, bool>>
+        void Dequeue(T& element);
+
+        template<typename = std::enable_if_t<std::is_copy_constructible_v<T> || std::is_move_constructible_v<T>, bool>>
+        bool TryDequeue(T& element);
+
+        [[nodiscard]] std::size_t GetSize() const noexcept;
+        [[nodiscard]] bool IsEmpty() const noexcept;
+        [[nodiscard]] std::size_t GetCapacity() const noexcept;
+
+        ~BoundedMPSCQueue() = default;
+
+    private:
+        using Slot = details::MPMCQueueSlot<T>;
+        using SlotAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Slot>;
+        using Buffer = details::RingBuffer<Slot, Capacity == kDynamicCapacity ? kDynamicCapacity : details::GetBufferSize(Capacity), SlotAllocator>;
+
+        Generation GetFreeGeneration(std::size_t i) const noexcept;
+        Generation GetWrittenGeneration(std::size_t i) const noexcept;
+
+        // Reads the element of the written slot at the head and publishes the next head
+        void Read(std::size_t head, T& element);
+
+    private:
+        PADDING(padding0_, 0);
+
+        Buffer buffer_;
+
+        PADDING(padding1_, sizeof(Buffer));
+
+        alignas(cache::kCacheLineSize) std::atomic<std::size_t> tail_{0};
+        alignas(cache::kCacheLineSize) std::atomic<std::size_t> head_{0}; // Written only by the consumer
+
+        PADDING(padding2_, 0);
+
+        [[no_unique_address]] WaitStrategy wait_strategy_; // Producers and the consumer wait on it for the generation of their slot
+    };
+
+
+    // Implementation
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    BoundedMPSCQueue<T, Capacity, Allocator, WaitStrategy>::BoundedMPSCQueue() requires (Capacity != kDynamicCapacity) : BoundedMPSCQueue(Allocator()) {}
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    BoundedMPSCQueue<T, Capacity, Allocator, WaitStrategy>::BoundedMPSCQueue(const Allocator& allocator) requires (Capacity != kDynamicCapacity)
+            : buffer_(SlotAllocator(allocator)) {}
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    BoundedMPSCQueue<T, Capacity, Allocator, WaitStrategy>::BoundedMPSCQueue(std::size_t capacity, const Allocator& allocator) requires (Capacity == kDynamicCapacity)
+            : buffer_(details::GetBufferSize(capacity), SlotAllocator(allocator)) {}
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    template<typename... Args, typename>
+    void BoundedMPSCQueue<T, Capacity, Allocator, WaitStrategy>::Emplace(Args&&... args) noexcept {
+        const std::size_t tail = tail_.fetch_add(1);
+
+        const std::size_t index = tail & buffer_.GetIndexMask();
+        const Generation generation = GetFreeGeneration(tail);
+
+        wait_strategy_.Wait([&] { return generation == buffer_[index].LoadGeneration(); });
+
+        buffer_[index].Construct(std::forward<Args>(args)...);
+        buffer_[index].StoreGeneration(generation + 1);
+        wait_strategy_.Notify();
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    template<typename... Args, typename>
+    bool BoundedMPSCQueue<T, Capacity, Allocator, WaitStrategy>::TryEmplace(Args&&... args) noexcept {
+        std::size_t tail = tail_.load(std::memory_order_acquire);
+        while (true) {
+            const std::size_t index = tail & buffer_.GetIndexMask();
+            const Generation generation = GetFreeGeneration(tail);
+            if (generation == buffer_[index].LoadGeneration()) {
+                if (tail_.compare_exchange_weak(tail, tail + 1)) {
+                    buffer_[index].Construct(std::forward<Args>(args)...);
+                    buffer_[index].StoreGeneration(generation + 1);
+                    wait_strategy_.Notify();
+                    return true;
+                }
+            } else {
+                const std::size_t new_tail = tail_.load(std::memory_order_acquire);
+                if (tail == new_tail) {
+                    return false;
+                }
+                tail = new_tail;
+            }
+        }
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    template<typename>
+    void BoundedMPSCQueue<T, Capacity, Allocator, WaitStrategy>::Enqueue(const T& element) noexcept {
+        Emplace(element);
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    template<typename>
+    bool BoundedMPSCQueue<T, Capacity, Allocator, WaitStrategy>::TryEnqueue(const T& element) noexcept {
+        return TryEmplace(element);
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    template<typename>
+    void BoundedMPSCQueue<T, Capacity, Allocator, WaitStrategy>::Enqueue(T&& element) noexcept {
+        Emplace(std::forward<T>(element));
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    template<typename>
+    bool BoundedMPSCQueue<T, Capacity, Allocator, WaitStrategy>::TryEnqueue(T&& element) noexcept {
+        return TryEmplace(std::forward<T>(element));
+    }
+
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    template<typename>
+    void BoundedMPSCQueue<T, Capacity, Allocator, WaitStrategy>::Dequeue(T& element) {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+
+        const std::size_t index = head & buffer_.GetIndexMask();
+        const Generation generation = GetWrittenGeneration(head);
+
+        wait_strategy_.Wait([&] { return generation == buffer_[index].LoadGeneration(); });
+
+        Read(head, element);
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    template<typename>
+    bool BoundedMPSCQueue<T, Capacity, Allocator, WaitStrategy>::TryDequeue(T& element) {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (GetWrittenGeneration(head) != buffer_[head & buffer_.GetIndexMask()].LoadGeneration()) {
+            return false;
+        }
+
+        Read(head, element);
+        return true;
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    std::size_t BoundedMPSCQueue<T, Capacity, Allocator, WaitStrategy>::GetSize() const noexcept {
+        const std::size_t head = head_.load(std::memory_order_acquire);
+        const std::size_t tail = tail_.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    bool BoundedMPSCQueue<T, Capacity, Allocator, WaitStrategy>::IsEmpty() const noexcept {
+        return GetSize() == 0;
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    std::size_t BoundedMPSCQueue<T, Capacity, Allocator, WaitStrategy>::GetCapacity() const noexcept {
+        return buffer_.GetSize();
+    }
+
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    Generation BoundedMPSCQueue<T, Capacity, Allocator, WaitStrategy>::GetFreeGeneration(std::size_t i) const noexcept {
+        return 2 * static_cast<Generation>(i >> buffer_.GetIndexShift());
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    Generation BoundedMPSCQueue<T, Capacity, Allocator, WaitStrategy>::GetWrittenGeneration(std::size_t i) const noexcept {
+        return GetFreeGeneration(i) + 1;
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    void BoundedMPSCQueue<T, Capacity, Allocator, WaitStrategy>::Read(std::size_t head, T& element) {
+        const std::size_t index = head & buffer_.GetIndexMask();
+
+        element = buffer_[index].Move();
+        buffer_[index].Destroy();
+        buffer_[index].StoreGeneration(GetWrittenGeneration(head) + 1);
+        head_.store(head + 1, std::memory_order_release);
+        wait_strategy_.Notify();
+    }
+
+} // End of namespace concurrent::queue
+
+#endif //LOCK_FREE_BOUNDED_MP_SC_QUEUE_H
@@ -1,7 +1,7 @@
 #ifndef LOCK_FREE_DATA_STRUCTURES_BOUNDED_SP_MC_QUEUE_H
 #define LOCK_FREE_DATA_STRUCTURES_BOUNDED_SP_MC_QUEUE_H
 
-#include <array>
+#include <memory>
 #include <atomic>
 #include <type_traits>
 #include <cstddef>
@@ -12,6 +12,8 @@
 #include "seq_lock.h"
 #include "atomic_memcpy.h"
 #include "wait.h"
+#include "bounded_queue.h"
+#include "instrumentation.h"
 
 namespace concurrent::queue {
 
@@ -77,25 +79,37 @@ namespace concurrent::queue {
         SeqLock seq_lock_{};
     };
 
-    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment = utils::kDefaultAlignment>
+    // Counters is the instrumentation policy. It counts the reads of the messages, which the writer has already overwritten
+    template<std::size_t MessagesCount,
+            std::size_t MaxMessageSize,
+            std::size_t MessageAlignment = utils::kDefaultAlignment,
+            typename Allocator = std::allocator<std::byte>,
+            typename WaitStrategy = wait::BusySpinWaitStrategy,
+            typename Counters = instrumentation::NoCounters>
     class BoundedMulticastQueue {
     private:
         using Message = MulticastQueueMessage<MaxMessageSize, MessageAlignment>;
         using AtomicMessage = AtomicMulticastQueueMessage<MaxMessageSize, MessageAlignment>;
+        using AtomicMessageAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<AtomicMessage>;
+        using Buffer = details::RingBuffer<AtomicMessage, MessagesCount == kDynamicCapacity ? kDynamicCapacity : std::bit_ceil(MessagesCount), AtomicMessageAllocator>;
 
     public:
-        BoundedMulticastQueue() = default;
+        BoundedMulticastQueue() requires (MessagesCount != kDynamicCapacity);
+        explicit BoundedMulticastQueue(const Allocator& allocator) requires (MessagesCount != kDynamicCapacity);
+        explicit BoundedMulticastQueue(std::size_t messages_count, const Allocator& allocator = Allocator()) requires (MessagesCount == kDynamicCapacity);
 
         BoundedMulticastQueue(const BoundedMulticastQueue&) = delete;
         BoundedMulticastQueue(BoundedMulticastQueue&&) = delete;
         BoundedMulticastQueue& operator=(const BoundedMulticastQueue&) = delete;
         BoundedMulticastQueue& operator=(BoundedMulticastQueue&&) = delete;
 
+        [[nodiscard]] const Counters& GetCounters() const noexcept;
+
         ~BoundedMulticastQueue() = default;
 
         class Writer {
         private:
-            using Queue = BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment>;
+            using Queue = BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment, Allocator, WaitStrategy, Counters>;
 
         public:
             explicit Writer(Queue* queue);
@@ -120,7 +134,7 @@ namespace concurrent::queue {
 
         class Reader {
         private:
-            using Queue = BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment>;
+            using Queue = BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment, Allocator, WaitStrategy, Counters>;
 
         public:
             explicit Reader(Queue* queue);
@@ -138,6 +152,7 @@ namespace concurrent::queue {
             template<typename T, typename = std::enable_if_t<utils::IsTriviallyCopyableAndDestructible<T>>>
             int32_t TryRead(T& message);
 
+            // Waits for the next message with the WaitStrategy.
             // true - The message was read
             // false - The data was overwritten several times. The reader is late
             bool Read(Message& message);
@@ -153,7 +168,7 @@ namespace concurrent::queue {
             ~Reader() = default;
 
         private:
-            static constexpr std::size_t GetSeqRightShiftValue();
+            std::size_t GetSeqRightShiftValue() const noexcept;
 
             Queue* queue_{nullptr};
             std::size_t head_{0};
@@ -164,10 +179,13 @@ namespace concurrent::queue {
         friend class Reader;
 
     private:
-        static constexpr std::size_t GetBufferSize();
-        static constexpr std::size_t GetIndexMask();
+        std::size_t GetBufferSize() const noexcept;
+        std::size_t GetIndexMask() const noexcept;
+
+        Buffer buffer_;
 
-        std::array<AtomicMessage, GetBufferSize()> buffer_{};
+        [[no_unique_address]] WaitStrategy wait_strategy_; // Readers wait on it for the next message
+        [[no_unique_address]] Counters counters_;
     };
 
 
@@ -255,19 +273,19 @@ namespace concurrent::queue {
     }
 
     // Writer
-    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment>
-    BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment>::Writer::Writer(
+    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment, typename Allocator, typename WaitStrategy, typename Counters>
+    BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment, Allocator, WaitStrategy, Counters>::Writer::Writer(
             BoundedMulticastQueue::Writer::Queue* queue) : queue_(queue)  {}
 
-    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment>
-    BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment>::Writer::Writer(
+    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment, typename Allocator, typename WaitStrategy, typename Counters>
+    BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment, Allocator, WaitStrategy, Counters>::Writer::Writer(
             BoundedMulticastQueue::Writer&& other) noexcept : queue_(other.queue_), tail_(other.tail_) {
         other.queue_ = nullptr;
         other.tail_ = 0;
     }
 
-    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment>
-    BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment>::Writer& BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment>::Writer::operator=(
+    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment, typename Allocator, typename WaitStrategy, typename Counters>
+    BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment, Allocator, WaitStrategy, Counters>::Writer& BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment, Allocator, WaitStrategy, Counters>::Writer::operator=(
             BoundedMulticastQueue::Writer&& other) noexcept {
         if (this != &other) {
             Swap(std::move(other));
@@ -275,15 +293,16 @@ namespace concurrent::queue {
         return *this;
     }
 
-    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment>
+    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment, typename Allocator, typename WaitStrategy, typename Counters>
     template<typename T, typename>
-    void BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment>::Writer::Write(T desired_message) {
+    void BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment, Allocator, WaitStrategy, Counters>::Writer::Write(T desired_message) {
         queue_->buffer_[tail_].Store(std::forward<T>(desired_message));
-        tail_ = (tail_ + 1) & BoundedMulticastQueue::GetIndexMask();
+        tail_ = (tail_ + 1) & queue_->GetIndexMask();
+        queue_->wait_strategy_.Notify();
     }
 
-    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment>
-    void BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment>::Writer::Swap(
+    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment, typename Allocator, typename WaitStrategy, typename Counters>
+    void BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment, Allocator, WaitStrategy, Counters>::Writer::Swap(
             BoundedMulticastQueue::Writer& other) noexcept {
         using std::swap;
         swap(queue_, other.queue_);
@@ -291,24 +310,24 @@ namespace concurrent::queue {
     }
 
     // Reader
-    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment>
-    BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment>::Reader::Reader(
+    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment, typename Allocator, typename WaitStrategy, typename Counters>
+    BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment, Allocator, WaitStrategy, Counters>::Reader::Reader(
             BoundedMulticastQueue::Reader::Queue* queue) : queue_(queue) {}
 
-    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment>
-    BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment>::Reader::Reader(
+    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment, typename Allocator, typename WaitStrategy, typename Counters>
+    BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment, Allocator, WaitStrategy, Counters>::Reader::Reader(
             const BoundedMulticastQueue::Reader& other) : queue_(other.queue_), head_(other.head_), expected_seq_(other.expected_seq_) {}
 
-    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment>
-    BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment>::Reader::Reader(
+    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment, typename Allocator, typename WaitStrategy, typename Counters>
+    BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment, Allocator, WaitStrategy, Counters>::Reader::Reader(
             BoundedMulticastQueue::Reader&& other) noexcept : queue_(other.queue_), head_(other.head_), expected_seq_(other.expected_seq_) {
         other.queue_ = nullptr;
         other.head_ = 0;
         other.expected_seq_ = 2;
     }
 
-    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment>
-    BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment>::Reader& BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment>::Reader::operator=(
+    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment, typename Allocator, typename WaitStrategy, typename Counters>
+    BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment, Allocator, WaitStrategy, Counters>::Reader& BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment, Allocator, WaitStrategy, Counters>::Reader::operator=(
             const BoundedMulticastQueue::Reader& other) {
         if (this != &other) {
             BoundedMulticastQueue::Reader tmp(std::forward<BoundedMulticastQueue::Reader>(other));
@@ -317,8 +336,8 @@ namespace concurrent::queue {
         return *this;
     }
 
-    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment>
-    BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment>::Reader& BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment>::Reader::operator=(
+    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment, typename Allocator, typename WaitStrategy, typename Counters>
+    BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment, Allocator, WaitStrategy, Counters>::Reader& BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment, Allocator, WaitStrategy, Counters>::Reader::operator=(
             BoundedMulticastQueue::Reader&& other) noexcept {
         if (this != &other) {
             Swap(std::move(other));
@@ -326,56 +345,60 @@ namespace concurrent::queue {
         return *this;
     }
 
-    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment>
-    int32_t BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment>::Reader::TryRead(
+    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment, typename Allocator, typename WaitStrategy, typename Counters>
+    int32_t BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment, Allocator, WaitStrategy, Counters>::Reader::TryRead(
             BoundedMulticastQueue::Message& message) {
         auto real_seq = queue_->buffer_[head_].Load(message);
-        return static_cast<int32_t>(real_seq) - static_cast<int32_t>(expected_seq_);
+        const int32_t result = static_cast<int32_t>(real_seq) - static_cast<int32_t>(expected_seq_);
+        if (result > 0) {
+            queue_->counters_.Add(instrumentation::Event::kReaderLapped);
+        }
+        return result;
     }
 
-    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment>
+    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment, typename Allocator, typename WaitStrategy, typename Counters>
     template<typename T, typename>
-    int32_t BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment>::Reader::TryRead(T& message) {
+    int32_t BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment, Allocator, WaitStrategy, Counters>::Reader::TryRead(T& message) {
         Message queue_message{};
         auto result = TryRead(queue_message);
         queue_message.Get(message);
         return result;
     }
 
-    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment>
-    bool BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment>::Reader::Read(
+    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment, typename Allocator, typename WaitStrategy, typename Counters>
+    bool BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment, Allocator, WaitStrategy, Counters>::Reader::Read(
             BoundedMulticastQueue::Message& message) {
-        while (true) {
-            int32_t result = TryRead(message);
-            if (!result) {
-                UpdateIndexes();
-                return true;
-            } else if (result > 0) {
-                return false;
-            } else {
-                concurrent::wait::Wait();
-            }
+        int32_t result = 0;
+        queue_->wait_strategy_.Wait([&] {
+            result = TryRead(message);
+            return result >= 0;
+        });
+
+        if (result > 0) {
+            return false;
         }
+        UpdateIndexes();
+        return true;
     }
 
-    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment>
+    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment, typename Allocator, typename WaitStrategy, typename Counters>
     template<typename T, typename>
-    bool BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment>::Reader::Read(T& message) {
+    bool BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment, Allocator, WaitStrategy, Counters>::Reader::Read(T& message) {
         Message queue_message{};
         auto result = Read(queue_message);
         queue_message.Get(message);
         return result;
     }
 
-    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment>
-    void BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment>::Reader::UpdateIndexes() {
+    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment, typename Allocator, typename WaitStrategy, typename Counters>
+    void BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment, Allocator, WaitStrategy, Counters>::Reader::UpdateIndexes() {
         ++head_;
         expected_seq_ += (head_ >> GetSeqRightShiftValue()) << 1u;
-        head_ &= BoundedMulticastQueue::GetIndexMask();
+        head_ &= queue_->GetIndexMask();
     }
 
-    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment>
-    void BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment>::Reader::Swap(
+    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment, typename Allocator, typename WaitStrategy, typename Counters>
+    void BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment, Allocator, WaitStrategy, Counters>::Reader::Swap(
             BoundedMulticastQueue::Reader& other) noexcept {
         using std::swap;
         swap(queue_, other.queue_);
@@ -383,22 +406,39 @@ namespace concurrent::queue {
         swap(expected_seq_, other.expected_seq_);
     }
 
-    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment>
-    constexpr std::size_t BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment>::Reader::GetSeqRightShiftValue() {
-        return __builtin_ctz(GetBufferSize());
+    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment, typename Allocator, typename WaitStrategy, typename Counters>
+    std::size_t BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment, Allocator, WaitStrategy, Counters>::Reader::GetSeqRightShiftValue() const noexcept {
+        return queue_->buffer_.GetIndexShift();
     }
 
 
     // BoundedMulticastQueue
-    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment>
-    constexpr std::size_t BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment>::GetBufferSize() {
-        // assert 4
-        return std::bit_ceil(MessagesCount);
+    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment, typename Allocator, typename WaitStrategy, typename Counters>
+    BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment, Allocator, WaitStrategy, Counters>::BoundedMulticastQueue()
+            requires (MessagesCount != kDynamicCapacity) : BoundedMulticastQueue(Allocator()) {}
+
+    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment, typename Allocator, typename WaitStrategy, typename Counters>
+    BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment, Allocator, WaitStrategy, Counters>::BoundedMulticastQueue(
+            const Allocator& allocator) requires (MessagesCount != kDynamicCapacity) : buffer_(AtomicMessageAllocator(allocator)) {}
+
+    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment, typename Allocator, typename WaitStrategy, typename Counters>
+    BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment, Allocator, WaitStrategy, Counters>::BoundedMulticastQueue(
+            std::size_t messages_count, const Allocator& allocator) requires (MessagesCount == kDynamicCapacity)
+            : buffer_(std::bit_ceil(messages_count), AtomicMessageAllocator(allocator)) {}
+
+    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment, typename Allocator, typename WaitStrategy, typename Counters>
+    const Counters& BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment, Allocator, WaitStrategy, Counters>::GetCounters() const noexcept {
+        return counters_;
+    }
+
+    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment, typename Allocator, typename WaitStrategy, typename Counters>
+    std::size_t BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment, Allocator, WaitStrategy, Counters>::GetBufferSize() const noexcept {
+        return buffer_.GetSize();
     }
 
-    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment>
-    constexpr std::size_t BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment>::GetIndexMask() {
-        return GetBufferSize() - 1;
+    template<std::size_t MessagesCount, std::size_t MaxMessageSize, std::size_t MessageAlignment, typename Allocator, typename WaitStrategy, typename Counters>
+    std::size_t BoundedMulticastQueue<MessagesCount, MaxMessageSize, MessageAlignment, Allocator, WaitStrategy, Counters>::GetIndexMask() const noexcept {
+        return buffer_.GetIndexMask();
     }
 
 } // End of namespace concurrent::queue
@@ -1,9 +1,172 @@
 #ifndef LOCK_FREE_DATA_STRUCTURES_BOUNDED_QUEUE_H
 #define LOCK_FREE_DATA_STRUCTURES_BOUNDED_QUEUE_H
 
+#include <memory>
+#include <limits>
+#include <bit>
+#include <span>
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+
 namespace concurrent::queue {
 
-    // todo create base bounded queue
+    // Pass it as the Capacity template parameter to set the capacity of the queue at runtime
+    inline constexpr std::size_t kDynamicCapacity = std::numeric_limits<std::size_t>::max();
+
+    // Elements of the ring buffer. The second part is not empty only if the elements wrap around the end of the buffer
+    template<typename T>
+    struct RingBufferSpan {
+        [[nodiscard]] std::size_t GetSize() const noexcept;
+        [[nodiscard]] bool IsEmpty() const noexcept;
+
+        std::span<T> first_;
+        std::span<T> second_;
+    };
+
+    namespace details {
+
+        // Returns the power of two buffer size, which is enough to store capacity elements and one empty cell
+        constexpr std::size_t GetBufferSize(std::size_t capacity);
+
+        // Ring buffer allocated with the Allocator.
+        // If Size is kDynamicCapacity, the size is passed to the constructor
+        template<typename T, std::size_t Size, typename Allocator = std::allocator<T>>
+        class RingBuffer {
+        private:
+            using AllocatorTraits = std::allocator_traits<Allocator>;
+
+        public:
+            explicit RingBuffer(const Allocator& allocator = Allocator()) requires (Size != kDynamicCapacity);
+            RingBuffer(std::size_t size, const Allocator& allocator = Allocator()) requires (Size == kDynamicCapacity);
+
+            RingBuffer(const RingBuffer&) = delete;
+            RingBuffer(RingBuffer&&) = delete;
+            RingBuffer& operator=(const RingBuffer&) = delete;
+            RingBuffer& operator=(RingBuffer&&) = delete;
+
+            T& operator[](std::size_t index) noexcept;
+            const T& operator[](std::size_t index) const noexcept;
+
+            T* GetData() noexcept;
+
+            [[nodiscard]] std::size_t GetSize() const noexcept;
+            [[nodiscard]] std::size_t GetIndexMask() const noexcept;
+            [[nodiscard]] std::size_t GetIndexShift() const noexcept; // log2 of the size
+
+            ~RingBuffer();
+
+        private:
+            void Allocate();
+
+        private:
+            [[no_unique_address]] Allocator allocator_;
+            T* data_{nullptr};
+            std::size_t size_;
+        };
+
+    }
+
+
+    // Implementation
+    template<typename T>
+    std::size_t RingBufferSpan<T>::GetSize() const noexcept {
+        return first_.size() + second_.size();
+    }
+
+    template<typename T>
+    bool RingBufferSpan<T>::IsEmpty() const noexcept {
+        return first_.empty();
+    }
+
+
+    namespace details {
+
+        constexpr std::size_t GetBufferSize(std::size_t capacity) {
+            capacity = capacity < 3 ? 4 : std::bit_ceil(capacity + 1);
+            assert(capacity && (capacity & (capacity - 1)) == 0); // is power of two
+            return capacity;
+        }
+
+        template<typename T, std::size_t Size, typename Allocator>
+        RingBuffer<T, Size, Allocator>::RingBuffer(const Allocator& allocator) requires (Size != kDynamicCapacity)
+                : allocator_(allocator), size_(Size) {
+            static_assert(Size && (Size & (Size - 1)) == 0, "The size of the ring buffer must be a power of two");
+            Allocate();
+        }
+
+        template<typename T, std::size_t Size, typename Allocator>
+        RingBuffer<T, Size, Allocator>::RingBuffer(std::size_t size, const Allocator& allocator) requires (Size == kDynamicCapacity)
+                : allocator_(allocator), size_(size) {
+            assert(size && (size & (size - 1)) == 0); // is power of two
+            Allocate();
+        }
+
+        template<typename T, std::size_t Size, typename Allocator>
+        void RingBuffer<T, Size, Allocator>::Allocate() {
+            data_ = AllocatorTraits::allocate(allocator_, GetSize());
+
+            if constexpr (!std::is_trivially_default_constructible_v<T>) {
+                std::size_t constructed = 0;
+                try {
+                    for (; constructed < GetSize(); ++constructed) {
+                        AllocatorTraits::construct(allocator_, data_ + constructed);
+                    }
+                } catch (...) {
+                    while (constructed) {
+                        AllocatorTraits::destroy(allocator_, data_ + --constructed);
+                    }
+                    AllocatorTraits::deallocate(allocator_, data_, GetSize());
+                    throw;
+                }
+            }
+        }
+
+        template<typename T, std::size_t Size, typename Allocator>
+        T& RingBuffer<T, Size, Allocator>::operator[](std::size_t index) noexcept {
+            return data_[index];
+        }
+
+        template<typename T, std::size_t Size, typename Allocator>
+        const T& RingBuffer<T, Size, Allocator>::operator[](std::size_t index) const noexcept {
+            return data_[index];
+        }
+
+        template<typename T, std::size_t Size, typename Allocator>
+        T* RingBuffer<T, Size, Allocator>::GetData() noexcept {
+            return data_;
+        }
+
+        template<typename T, std::size_t Size, typename Allocator>
+        std::size_t RingBuffer<T, Size, Allocator>::GetSize() const noexcept {
+            if constexpr (Size != kDynamicCapacity) {
+                return Size;
+            } else {
+                return size_;
+            }
+        }
+
+        template<typename T, std::size_t Size, typename Allocator>
+        std::size_t RingBuffer<T, Size, Allocator>::GetIndexMask() const noexcept {
+            return GetSize() - 1;
+        }
+
+        template<typename T, std::size_t Size, typename Allocator>
+        std::size_t RingBuffer<T, Size, Allocator>::GetIndexShift() const noexcept {
+            return std::countr_zero(GetSize());
+        }
+
+        template<typename T, std::size_t Size, typename Allocator>
+        RingBuffer<T, Size, Allocator>::~RingBuffer() {
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+                for (std::size_t i = 0; i < GetSize(); ++i) {
+                    AllocatorTraits::destroy(allocator_, data_ + i);
+                }
+            }
+            AllocatorTraits::deallocate(allocator_, data_, GetSize());
+        }
+
+    }
 
 } // End of namespace concurrent::queue
 
@@ -0,0 +1,299 @@
+#ifndef LOCK_FREE_BOUNDED_SP_SC_BYTE_QUEUE_H
+#define LOCK_FREE_BOUNDED_SP_SC_BYTE_QUEUE_H
+
+#include <memory>
+#include <atomic>
+#include <type_traits>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <bit>
+#include <algorithm>
+
+#include "cache_line.h"
+#include "utils.h"
+#include "bounded_queue.h"
+
+namespace concurrent::queue {
+
+    namespace details {
+
+        // Every frame starts with the header block. The message is stored in the next blocks
+        struct ByteQueueFrameHeader {
+            std::uint32_t size_{0};
+        };
+
+        // The header of the frame, which fills the end of the buffer. The reader must skip it and go to the beginning
+        inline constexpr std::uint32_t kPaddingFrameSize = std::numeric_limits<std::uint32_t>::max();
+
+        // The message of one block must fit in the buffer even if the previous frame ends right before the last block,
+        // so the buffer has at least two frames of two blocks
+        inline constexpr std::size_t kMinByteQueueBlocksCount = 4;
+
+        // The number of blocks of the buffer of capacity bytes, the power of two not less than kMinByteQueueBlocksCount
+        constexpr std::size_t GetByteQueueBlocksCount(std::size_t capacity, std::size_t alignment) {
+            return std::max(std::bit_ceil((capacity + alignment - 1) / alignment), kMinByteQueueBlocksCount);
+        }
+
+        template<std::size_t Alignment>
+        struct alignas(Alignment) ByteQueueBlock {
+            std::byte data_[Alignment];
+        };
+
+    }
+
+    // Single producer single consumer queue of the variable-length messages.
+    // Every message is stored contiguously in the buffer as a length-prefixed frame aligned to the Alignment.
+    // Capacity is the size of the buffer in bytes. The dynamic capacity is rounded up to at least kMinByteQueueBlocksCount blocks
+    template<std::size_t Capacity = kDynamicCapacity,
+            std::size_t Alignment = utils::kDefaultAlignment,
+            typename Allocator = std::allocator<std::byte>>
+    class BoundedSPSCByteQueue final {
+    private:
+        using Block = details::ByteQueueBlock<Alignment>;
+        using BlockAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Block>;
+        using Buffer = details::RingBuffer<Block, Capacity == kDynamicCapacity ? kDynamicCapacity : std::bit_ceil((Capacity + Alignment - 1) / Alignment), BlockAllocator>;
+
+        static_assert(std::has_single_bit(Alignment), "Alignment must be a power of two");
+        static_assert(Alignment >= sizeof(details::ByteQueueFrameHeader), "The frame header must fit in one block");
+        static_assert(Capacity == kDynamicCapacity || std::bit_ceil((Capacity + Alignment - 1) / Alignment) >= details::kMinByteQueueBlocksCount,
+                      "Capacity must hold at least kMinByteQueueBlocksCount blocks");
+
+    public:
+        BoundedSPSCByteQueue() requires (Capacity != kDynamicCapacity);
+        explicit BoundedSPSCByteQueue(const Allocator& allocator) requires (Capacity != kDynamicCapacity);
+        explicit BoundedSPSCByteQueue(std::size_t capacity, const Allocator& allocator = Allocator()) requires (Capacity == kDynamicCapacity);
+
+        BoundedSPSCByteQueue(const BoundedSPSCByteQueue&) = delete;
+        BoundedSPSCByteQueue(BoundedSPSCByteQueue&&) = delete;
+        BoundedSPSCByteQueue& operator=(const BoundedSPSCByteQueue&) = delete;
+        BoundedSPSCByteQueue& operator=(BoundedSPSCByteQueue&&) = delete;
+
+        // Returns the contiguous space for the message of the given size.
+        // If the queue is full, the data of the returned span is nullptr. The size must not exceed GetMaxMessageSize()
+        std::span<std::byte> Reserve(std::size_t size);
+
+        // Publishes the reserved message. The size can be less than the reserved one
+        void Commit(std::size_t size) noexcept;
+
+        bool Enqueue(std::span<const std::byte> message);
+
+        template<typename T>
+        requires utils::IsTriviallyCopyable<T>
+        bool Enqueue(const T& message);
+
+        // Returns the front message. If the queue is empty, the data of the returned span is nullptr
+        std::span<const std::byte> Front();
+
+        bool Dequeue();
+
+        [[nodiscard]] bool IsEmptyConsumer(); // IsEmpty method for consumer. It is faster than IsEmptyProducer()
+        [[nodiscard]] bool IsEmptyProducer() const noexcept; // IsEmpty method for producer
+        [[nodiscard]] std::size_t GetCapacity() const noexcept; // In bytes
+        [[nodiscard]] std::size_t GetMaxMessageSize() const noexcept;
+
+        ~BoundedSPSCByteQueue() = default;
+
+    private:
+        static constexpr std::size_t GetFrameBlocksCount(std::size_t size);
+
+        std::size_t GetIndexMask() const noexcept;
+
+        // The number of free blocks for producer. The cached head is updated only if it is less than required_count
+        std::size_t GetFreeBlocksCount(std::size_t tail, std::size_t required_count);
+
+        void StoreHeader(std::size_t index, std::uint32_t size) noexcept;
+        std::uint32_t LoadHeader(std::size_t index) noexcept;
+
+        std::byte* GetMessageData(std::size_t header_index) noexcept;
+
+    private:
+        PADDING(padding0_, 0);
+
+        Buffer buffer_;
+
+        PADDING(padding1_, sizeof(Buffer));
+
+        // Indexes of the blocks. They are not wrapped, so the size of the queue is tail_ - head_
+        alignas(cache::kCacheLineSize) std::atomic<std::size_t> tail_{0};
+        std::size_t cached_head_{0};
+        std::size_t reserved_tail_{0};
+
+        PADDING(padding2_, sizeof(std::atomic<std::size_t>) + 2 * sizeof(std::size_t));
+
+        alignas(cache::kCacheLineSize) std::atomic<std::size_t> head_{0};
+        std::size_t cached_tail_{0};
+
+        PADDING(padding3_, sizeof(std::atomic<std::size_t>) + sizeof(std::size_t));
+    };
+
+
+    // Implementation
+    template<std::size_t Capacity, std::size_t Alignment, typename Allocator>
+    BoundedSPSCByteQueue<Capacity, Alignment, Allocator>::BoundedSPSCByteQueue() requires (Capacity != kDynamicCapacity)
+            : BoundedSPSCByteQueue(Allocator()) {}
+
+    template<std::size_t Capacity, std::size_t Alignment, typename Allocator>
+    BoundedSPSCByteQueue<Capacity, Alignment, Allocator>::BoundedSPSCByteQueue(const Allocator& allocator) requires (Capacity != kDynamicCapacity)
+            : buffer_(BlockAllocator(allocator)) {}
+
+    template<std::size_t Capacity, std::size_t Alignment, typename Allocator>
+    BoundedSPSCByteQueue<Capacity, Alignment, Allocator>::BoundedSPSCByteQueue(std::size_t capacity, const Allocator& allocator) requires (Capacity == kDynamicCapacity)
+            : buffer_(details::GetByteQueueBlocksCount(capacity, Alignment), BlockAllocator(allocator)) {}
+
+    template<std::size_t Capacity, std::size_t Alignment, typename Allocator>
+    std::span<std::byte> BoundedSPSCByteQueue<Capacity, Alignment, Allocator>::Reserve(std::size_t size) {
+        assert(size <= GetMaxMessageSize());
+
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        const std::size_t frame_blocks_count = GetFrameBlocksCount(size);
+
+        const std::size_t index = tail & GetIndexMask();
+        const std::size_t blocks_to_end = buffer_.GetSize() - index;
+
+        // If the frame does not fit before the end of the buffer, the rest of the buffer is skipped
+        const bool is_wrapped = frame_blocks_count > blocks_to_end;
+        const std::size_t required_count = is_wrapped ? blocks_to_end + frame_blocks_count : frame_blocks_count;
+
+        if (GetFreeBlocksCount(tail, required_count) < required_count) {
+            return {};
+        }
+
+        if (is_wrapped) {
+            StoreHeader(index, details::kPaddingFrameSize);
+            tail += blocks_to_end;
+        }
+
+        reserved_tail_ = tail;
+        return {GetMessageData(tail & GetIndexMask()), size};
+    }
+
+    template<std::size_t Capacity, std::size_t Alignment, typename Allocator>
+    void BoundedSPSCByteQueue<Capacity, Alignment, Allocator>::Commit(std::size_t size) noexcept {
+        StoreHeader(reserved_tail_ & GetIndexMask(), static_cast<std::uint32_t>(size));
+        tail_.store(reserved_tail_ + GetFrameBlocksCount(size), std::memory_order_release);
+    }
+
+    template<std::size_t Capacity, std::size_t Alignment, typename Allocator>
+    bool BoundedSPSCByteQueue<Capacity, Alignment, Allocator>::Enqueue(std::span<const std::byte> message) {
+        std::span<std::byte> frame = Reserve(message.size());
+        if (frame.data() == nullptr) {
+            return false;
+        }
+
+        std::memcpy(frame.data(), message.data(), message.size());
+        Commit(message.size());
+
+        return true;
+    }
+
+    template<std::size_t Capacity, std::size_t Alignment, typename Allocator>
+    template<typename T>
+    requires utils::IsTriviallyCopyable<T>
+    bool BoundedSPSCByteQueue<Capacity, Alignment, Allocator>::Enqueue(const T& message) {
+        return Enqueue(std::span<const std::byte>(reinterpret_cast<const std::byte*>(&message), sizeof(message)));
+    }
+
+    template<std::size_t Capacity, std::size_t Alignment, typename Allocator>
+    std::span<const std::byte> BoundedSPSCByteQueue<Capacity, Alignment, Allocator>::Front() {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+
+        while (true) {
+            if (head == cached_tail_) {
+                cached_tail_ = tail_.load(std::memory_order_acquire);
+                if (head == cached_tail_) {
+                    return {};
+                }
+            }
+
+            const std::size_t index = head & GetIndexMask();
+            const std::uint32_t size = LoadHeader(index);
+
+            if (size != details::kPaddingFrameSize) {
+                return {GetMessageData(index), size};
+            }
+
+            head += buffer_.GetSize() - index;
+            head_.store(head, std::memory_order_release);
+        }
+    }
+
+    template<std::size_t Capacity, std::size_t Alignment, typename Allocator>
+    bool BoundedSPSCByteQueue<Capacity, Alignment, Allocator>::Dequeue() {
+        std::span<const std::byte> message = Front();
+        if (message.data() == nullptr) {
+            return false;
+        }
+
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        head_.store(head + GetFrameBlocksCount(message.size()), std::memory_order_release);
+
+        return true;
+    }
+
+    template<std::size_t Capacity, std::size_t Alignment, typename Allocator>
+    bool BoundedSPSCByteQueue<Capacity, Alignment, Allocator>::IsEmptyConsumer() {
+        return Front().data() == nullptr;
+    }
+
+    template<std::size_t Capacity, std::size_t Alignment, typename Allocator>
+    bool BoundedSPSCByteQueue<Capacity, Alignment, Allocator>::IsEmptyProducer() const noexcept {
+        return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire);
+    }
+
+    template<std::size_t Capacity, std::size_t Alignment, typename Allocator>
+    std::size_t BoundedSPSCByteQueue<Capacity, Alignment, Allocator>::GetCapacity() const noexcept {
+        return buffer_.GetSize() * Alignment;
+    }
+
+    template<std::size_t Capacity, std::size_t Alignment, typename Allocator>
+    std::size_t BoundedSPSCByteQueue<Capacity, Alignment, Allocator>::GetMaxMessageSize() const noexcept {
+        // The message must fit in the buffer even if the previous frame ends right before the last block
+        return (buffer_.GetSize() / 2 - 1) * Alignment;
+    }
+
+
+    template<std::size_t Capacity, std::size_t Alignment, typename Allocator>
+    constexpr std::size_t BoundedSPSCByteQueue<Capacity, Alignment, Allocator>::GetFrameBlocksCount(std::size_t size) {
+        return 1 + (size + Alignment - 1) / Alignment;
+    }
+
+    template<std::size_t Capacity, std::size_t Alignment, typename Allocator>
+    std::size_t BoundedSPSCByteQueue<Capacity, Alignment, Allocator>::GetIndexMask() const noexcept {
+        return buffer_.GetIndexMask();
+    }
+
+    template<std::size_t Capacity, std::size_t Alignment, typename Allocator>
+    std::size_t BoundedSPSCByteQueue<Capacity, Alignment, Allocator>::GetFreeBlocksCount(std::size_t tail, std::size_t required_count) {
+        std::size_t free_count = buffer_.GetSize() - (tail - cached_head_);
+        if (free_count < required_count) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            free_count = buffer_.GetSize() - (tail - cached_head_);
+        }
+        return free_count;
+    }
+
+    template<std::size_t Capacity, std::size_t Alignment, typename Allocator>
+    void BoundedSPSCByteQueue<Capacity, Alignment, Allocator>::StoreHeader(std::size_t index, std::uint32_t size) noexcept {
+        const details::ByteQueueFrameHeader header{size};
+        std::memcpy(buffer_[index].data_, &header, sizeof(header));
+    }
+
+    template<std::size_t Capacity, std::size_t Alignment, typename Allocator>
+    std::uint32_t BoundedSPSCByteQueue<Capacity, Alignment, Allocator>::LoadHeader(std::size_t index) noexcept {
+        details::ByteQueueFrameHeader header;
+        std::memcpy(&header, buffer_[index].data_, sizeof(header));
+        return header.size_;
+    }
+
+    template<std::size_t Capacity, std::size_t Alignment, typename Allocator>
+    std::byte* BoundedSPSCByteQueue<Capacity, Alignment, Allocator>::GetMessageData(std::size_t header_index) noexcept {
+        return reinterpret_cast<std::byte*>(buffer_.GetData() + header_index + 1);
+    }
+
+} // End of namespace concurrent::queue
+
+#endif //LOCK_FREE_BOUNDED_SP_SC_BYTE_QUEUE_H
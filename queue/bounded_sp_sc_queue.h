@@ -2,22 +2,42 @@
 #define LOCK_FREE_BOUNDED_SP_SC_QUEUE_H
 
 #include <memory>
-#include <cmath>
 #include <atomic>
 #include <type_traits>
-#include <array>
 #include <cassert>
 #include <utility>
-#include <climits>
+#include <iterator>
+#include <algorithm>
+#include <cstring>
+#include <span>
+#include <new>
+#include <chrono>
 
 #include "cache_line.h"
+#include "utils.h"
+#include "wait.h"
+#include "bounded_queue.h"
+#include "instrumentation.h"
 
 namespace concurrent::queue {
 
-    template<typename T, std::size_t Capacity>
+    // The consumer publishes head_ after every dequeue
+    inline constexpr std::size_t kEagerHeadPublication = 1;
+
+    // The elements are stored in the uninitialized storage. They are constructed on enqueue and destroyed on dequeue,
+    // so the construction of the queue does not touch the buffer.
+    // If HeadPublicationPeriod is greater than 1, the consumer publishes head_ only every HeadPublicationPeriod
+    // dequeued elements, when the producer requests it because the queue looks full, or when the queue is empty.
+    // It reduces the number of invalidations of the line the producer reads the head from.
+    // Counters is the instrumentation policy. It counts the reloads of the cached head and tail
+    template<typename T, std::size_t Capacity = kDynamicCapacity, typename Allocator = std::allocator<T>,
+             typename WaitStrategy = wait::BusySpinWaitStrategy, std::size_t HeadPublicationPeriod = kEagerHeadPublication,
+             typename Counters = instrumentation::NoCounters>
     class BoundedSPSCQueue final {
     public:
-        BoundedSPSCQueue() = default;
+        BoundedSPSCQueue() requires (Capacity != kDynamicCapacity);
+        explicit BoundedSPSCQueue(const Allocator& allocator) requires (Capacity != kDynamicCapacity);
+        explicit BoundedSPSCQueue(std::size_t capacity, const Allocator& allocator = Allocator()) requires (Capacity == kDynamicCapacity);
 
         BoundedSPSCQueue(const BoundedSPSCQueue&) = delete;
         BoundedSPSCQueue(BoundedSPSCQueue&&) = delete;
@@ -40,23 +60,117 @@ namespace concurrent::queue {
         template<typename = std::enable_if_t<std::is_copy_constructible_v<T> || std::is_move_constructible_v<T>, bool>>
         bool Dequeue(T& element);
 
+        // Blocking versions of Emplace, Enqueue and Dequeue. They wait with the WaitStrategy until the operation succeeds
+        template<typename... Args>
+        void BlockingEmplace(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>);
+
+        void BlockingEnqueue(const T& element) noexcept(std::is_nothrow_copy_constructible_v<T>);
+        void BlockingEnqueue(T&& element) noexcept(std::is_nothrow_move_constructible_v<T>);
+
+        void BlockingDequeue(T& element);
+
+        // Timed versions of Emplace, Enqueue and Dequeue. They wait with the WaitStrategy until the operation succeeds
+        // or the deadline expires. Return false on the timeout
+        template<typename Clock, typename Duration, typename... Args>
+        bool TryEmplaceUntil(const std::chrono::time_point<Clock, Duration>& deadline, Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>);
+
+        template<typename Rep, typename Period, typename... Args>
+        bool TryEmplaceFor(const std::chrono::duration<Rep, Period>& timeout, Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>);
+
+        template<typename Clock, typename Duration>
+        bool TryEnqueueUntil(const T& element, const std::chrono::time_point<Clock, Duration>& deadline) noexcept(std::is_nothrow_copy_constructible_v<T>);
+
+        template<typename Clock, typename Duration>
+        bool TryEnqueueUntil(T&& element, const std::chrono::time_point<Clock, Duration>& deadline) noexcept(std::is_nothrow_move_constructible_v<T>);
+
+        template<typename Rep, typename Period>
+        bool TryEnqueueFor(const T& element, const std::chrono::duration<Rep, Period>& timeout) noexcept(std::is_nothrow_copy_constructible_v<T>);
+
+        template<typename Rep, typename Period>
+        bool TryEnqueueFor(T&& element, const std::chrono::duration<Rep, Period>& timeout) noexcept(std::is_nothrow_move_constructible_v<T>);
+
+        template<typename Clock, typename Duration>
+        bool TryDequeueUntil(T& element, const std::chrono::time_point<Clock, Duration>& deadline);
+
+        template<typename Rep, typename Period>
+        bool TryDequeueFor(T& element, const std::chrono::duration<Rep, Period>& timeout);
+
+        // Enqueues as many elements from [first, last) as fit in the queue and publishes them at once.
+        // Returns the number of enqueued elements
+        template<std::forward_iterator InputIt>
+        std::size_t EnqueueBulk(InputIt first, InputIt last);
+
+        // Dequeues up to max_count elements to out and publishes the new head at once.
+        // Returns the number of dequeued elements
+        template<typename OutputIt>
+        std::size_t DequeueBulk(OutputIt out, std::size_t max_count);
+
+        // Returns up to count contiguous free slots, which the producer can write the elements to in place.
+        // The span is shorter than count if the queue is almost full or the free slots wrap around the end of the buffer.
+        // The slots are not constructed, so only trivially copyable types are supported
+        std::span<T> Reserve(std::size_t count) requires utils::IsTriviallyCopyable<T>;
+
+        // Publishes the first count elements of the reserved span
+        void Commit(std::size_t count) noexcept requires utils::IsTriviallyCopyable<T>;
+
+        // Returns up to max_count elements, which the consumer can read in place
+        RingBufferSpan<T> Peek(std::size_t max_count);
+
+        // Destroys the first count elements of the peeked span
+        void Release(std::size_t count) noexcept;
+
         [[nodiscard]] bool IsEmptyConsumer(); // IsEmpty method for consumer. It is faster than IsEmptyProducer()
         [[nodiscard]] bool IsEmptyProducer() const noexcept; // IsEmpty method for producer
         [[nodiscard]] std::size_t GetSize() const noexcept;
-        [[nodiscard]] std::size_t GetCapacity() const noexcept;
+        [[nodiscard]] std::size_t GetCapacity() const noexcept; // The number of elements, which can be enqueued. One slot of the ring is always free
 
-        ~BoundedSPSCQueue() = default;
+        [[nodiscard]] const Counters& GetCounters() const noexcept;
+
+        ~BoundedSPSCQueue();
 
     private:
-        static constexpr std::size_t GetBufferSize();
-        static constexpr std::size_t GetIndexMask();
+        using Storage = std::aligned_storage_t<sizeof(T), alignof(T)>;
+        using StorageAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Storage>;
+        using Buffer = details::RingBuffer<Storage, Capacity == kDynamicCapacity ? kDynamicCapacity : details::GetBufferSize(Capacity), StorageAllocator>;
+
+        static_assert(sizeof(Storage) == sizeof(T), "The elements must be stored without gaps");
+
+        T* GetElement(std::size_t index) noexcept;
+
+        // Destroys count elements starting from index. Does nothing for trivially destructible types
+        void DestroyElements(std::size_t index, std::size_t count) noexcept;
+
+        std::size_t GetBufferSize() const noexcept;
+        std::size_t GetIndexMask() const noexcept;
+
+        // The number of free slots for producer. The cached head is updated only if it is less than required_count
+        std::size_t GetFreeSize(std::size_t tail, std::size_t required_count);
+
+        // The number of elements for consumer. The cached tail is updated only if it is less than required_count
+        std::size_t GetReadableSize(std::size_t head, std::size_t required_count);
+
+        static constexpr bool IsLazyHeadPublication() noexcept;
+
+        // The head of the consumer. It can be ahead of head_ if the head publication is lazy
+        std::size_t LoadConsumerHead() const noexcept;
+
+        // Moves the head of the consumer by released_count elements.
+        // Publishes it if the publication is eager, the period is reached or the producer requested it
+        void StoreConsumerHead(std::size_t head, std::size_t released_count) noexcept;
+
+        // Publishes the head of the consumer if there are the unpublished dequeued elements. Called when the queue is empty
+        void FlushConsumerHead() noexcept;
+        void PublishConsumerHead() noexcept;
+
+        // Asks the consumer to publish its head. Called by producer, when the queue looks full
+        void RequestConsumerHead() noexcept;
 
     private:
         PADDING(padding0_, 0);
 
-        std::array<T, GetBufferSize()> buffer_{};
+        Buffer buffer_;
 
-        PADDING(padding1_, 0);
+        PADDING(padding1_, sizeof(Buffer));
 
         alignas(cache::kCacheLineSize) std::atomic<std::size_t> tail_{0};
         std::size_t cached_head_{0};
@@ -67,106 +181,309 @@ namespace concurrent::queue {
         std::size_t cached_tail_{0};
 
         PADDING(padding3_, sizeof(std::atomic<std::size_t>) + sizeof(std::size_t));
+
+        // The private head of the consumer. Used only if the head publication is lazy
+        alignas(cache::kCacheLineSize) std::size_t consumer_head_{0};
+        std::size_t unpublished_count_{0};
+
+        PADDING(padding4_, 2 * sizeof(std::size_t));
+
+        alignas(cache::kCacheLineSize) std::atomic<bool> is_head_requested_{false};
+
+        PADDING(padding5_, sizeof(std::atomic<bool>));
+
+        [[no_unique_address]] WaitStrategy producer_wait_strategy_; // The producer waits on it while the queue is full
+        [[no_unique_address]] WaitStrategy consumer_wait_strategy_; // The consumer waits on it while the queue is empty
+        [[no_unique_address]] Counters counters_;
     };
 
 
-    template<typename T, std::size_t Capacity>
-    T* BoundedSPSCQueue<T, Capacity>::Front() {
-        std::size_t head = head_.load(std::memory_order_acquire);
+    // Implementation
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::BoundedSPSCQueue() requires (Capacity != kDynamicCapacity) : BoundedSPSCQueue(Allocator()) {}
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::BoundedSPSCQueue(const Allocator& allocator) requires (Capacity != kDynamicCapacity)
+            : buffer_(StorageAllocator(allocator)) {}
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::BoundedSPSCQueue(std::size_t capacity, const Allocator& allocator) requires (Capacity == kDynamicCapacity)
+            : buffer_(details::GetBufferSize(capacity), StorageAllocator(allocator)) {}
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    T* BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::Front() {
+        std::size_t head = LoadConsumerHead();
 
         if (head == cached_tail_) {
             cached_tail_ = tail_.load(std::memory_order_acquire);
+            counters_.Add(instrumentation::Event::kCachedTailRefresh);
             if (head == cached_tail_) {
+                FlushConsumerHead();
                 return nullptr;
             }
         }
-        return &buffer_[head];
+        return GetElement(head);
     }
 
-    template<typename T, std::size_t Capacity>
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
     template<typename... Args>
-    bool BoundedSPSCQueue<T, Capacity>::Emplace(Args &&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>) {
+    bool BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::Emplace(Args &&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>) {
         const std::size_t tail = tail_.load(std::memory_order_acquire);
         std::size_t next_tail = (tail + 1) & GetIndexMask();
 
         if (next_tail == cached_head_) {
             cached_head_ = head_.load(std::memory_order_acquire);
+            counters_.Add(instrumentation::Event::kCachedHeadRefresh);
             if (next_tail == cached_head_) {
+                RequestConsumerHead();
                 return false;
             }
         }
 
         new (&buffer_[tail]) T(std::forward<Args>(args)...);
         tail_.store(next_tail, std::memory_order_release);
+        consumer_wait_strategy_.Notify();
 
         return true;
     }
 
-    template<typename T, std::size_t Capacity>
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
     template<typename>
-    bool BoundedSPSCQueue<T, Capacity>::Enqueue(const T& element) noexcept(std::is_nothrow_copy_constructible_v<T>) {
+    bool BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::Enqueue(const T& element) noexcept(std::is_nothrow_copy_constructible_v<T>) {
         return Emplace(element);
     }
 
-    template<typename T, std::size_t Capacity>
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
     template<typename>
-    bool BoundedSPSCQueue<T, Capacity>::Enqueue(T&& element) noexcept(std::is_nothrow_move_constructible_v<T>) {
+    bool BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::Enqueue(T&& element) noexcept(std::is_nothrow_move_constructible_v<T>) {
         return Emplace(std::forward<T>(element));
     }
 
-    template<typename T, std::size_t Capacity>
-    bool BoundedSPSCQueue<T, Capacity>::Dequeue() {
-        std::size_t head = head_.load(std::memory_order_acquire);
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    bool BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::Dequeue() {
+        std::size_t head = LoadConsumerHead();
 
         if (head == cached_tail_) {
             cached_tail_ = tail_.load(std::memory_order_acquire);
+            counters_.Add(instrumentation::Event::kCachedTailRefresh);
             if (head == cached_tail_) {
+                FlushConsumerHead();
                 return false;
             }
         }
 
-        head = (head + 1) & GetIndexMask();
-        head_.store(head, std::memory_order_release);
+        DestroyElements(head, 1);
+
+        StoreConsumerHead((head + 1) & GetIndexMask(), 1);
 
         return true;
     }
 
-    template<typename T, std::size_t Capacity>
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
     template<typename>
-    bool BoundedSPSCQueue<T, Capacity>::Dequeue(T &element) {
-        std::size_t head = head_.load(std::memory_order_acquire);
+    bool BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::Dequeue(T &element) {
+        std::size_t head = LoadConsumerHead();
 
         if (head == cached_tail_) {
             cached_tail_ = tail_.load(std::memory_order_acquire);
+            counters_.Add(instrumentation::Event::kCachedTailRefresh);
             if (head == cached_tail_) {
+                FlushConsumerHead();
                 return false;
             }
         }
 
         if constexpr (std::is_move_constructible_v<T>) {
-            element = std::move(buffer_[head]);
+            element = std::move(*GetElement(head));
         } else {
-            element = buffer_[head];
+            element = *GetElement(head);
         }
+        DestroyElements(head, 1);
 
-        head = (head + 1) & GetIndexMask();
-        head_.store(head, std::memory_order_release);
+        StoreConsumerHead((head + 1) & GetIndexMask(), 1);
 
         return true;
     }
 
-    template<typename T, std::size_t Capacity>
-    bool BoundedSPSCQueue<T, Capacity>::IsEmptyConsumer() {
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    template<typename... Args>
+    void BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::BlockingEmplace(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>) {
+        // Emplace uses the arguments only if it succeeds, so they can be forwarded on every attempt
+        producer_wait_strategy_.Wait([&] { return Emplace(std::forward<Args>(args)...); });
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    void BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::BlockingEnqueue(const T& element) noexcept(std::is_nothrow_copy_constructible_v<T>) {
+        BlockingEmplace(element);
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    void BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::BlockingEnqueue(T&& element) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        BlockingEmplace(std::move(element));
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    void BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::BlockingDequeue(T& element) {
+        consumer_wait_strategy_.Wait([&] { return Dequeue(element); });
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    template<typename Clock, typename Duration, typename... Args>
+    bool BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::TryEmplaceUntil(const std::chrono::time_point<Clock, Duration>& deadline,
+                                                                                        Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>) {
+        return producer_wait_strategy_.WaitUntil([&] { return Emplace(std::forward<Args>(args)...); }, deadline);
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    template<typename Rep, typename Period, typename... Args>
+    bool BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::TryEmplaceFor(const std::chrono::duration<Rep, Period>& timeout,
+                                                                                      Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>) {
+        return TryEmplaceUntil(std::chrono::steady_clock::now() + timeout, std::forward<Args>(args)...);
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    template<typename Clock, typename Duration>
+    bool BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::TryEnqueueUntil(const T& element, const std::chrono::time_point<Clock, Duration>& deadline) noexcept(std::is_nothrow_copy_constructible_v<T>) {
+        return TryEmplaceUntil(deadline, element);
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    template<typename Clock, typename Duration>
+    bool BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::TryEnqueueUntil(T&& element, const std::chrono::time_point<Clock, Duration>& deadline) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        return TryEmplaceUntil(deadline, std::move(element));
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    template<typename Rep, typename Period>
+    bool BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::TryEnqueueFor(const T& element, const std::chrono::duration<Rep, Period>& timeout) noexcept(std::is_nothrow_copy_constructible_v<T>) {
+        return TryEmplaceFor(timeout, element);
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    template<typename Rep, typename Period>
+    bool BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::TryEnqueueFor(T&& element, const std::chrono::duration<Rep, Period>& timeout) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        return TryEmplaceFor(timeout, std::move(element));
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    template<typename Clock, typename Duration>
+    bool BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::TryDequeueUntil(T& element, const std::chrono::time_point<Clock, Duration>& deadline) {
+        return consumer_wait_strategy_.WaitUntil([&] { return Dequeue(element); }, deadline);
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    template<typename Rep, typename Period>
+    bool BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::TryDequeueFor(T& element, const std::chrono::duration<Rep, Period>& timeout) {
+        return TryDequeueUntil(element, std::chrono::steady_clock::now() + timeout);
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    template<std::forward_iterator InputIt>
+    std::size_t BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::EnqueueBulk(InputIt first, InputIt last) {
+        const std::size_t tail = tail_.load(std::memory_order_acquire);
+        std::size_t count = std::distance(first, last);
+
+        count = std::min(count, GetFreeSize(tail, count));
+        if (!count) {
+            return 0;
+        }
+
+        const std::size_t first_segment_size = std::min(count, GetBufferSize() - tail);
+
+        if constexpr (std::is_trivially_copyable_v<T> && std::contiguous_iterator<InputIt>) {
+            const T* elements = std::to_address(first);
+            std::memcpy(&buffer_[tail], elements, first_segment_size * sizeof(T));
+            std::memcpy(&buffer_[0], elements + first_segment_size, (count - first_segment_size) * sizeof(T));
+        } else {
+            std::size_t constructed = 0;
+            try {
+                for (; constructed < count; ++constructed, ++first) {
+                    new (&buffer_[(tail + constructed) & GetIndexMask()]) T(*first);
+                }
+            } catch (...) {
+                DestroyElements(tail, constructed);
+                throw;
+            }
+        }
+
+        tail_.store((tail + count) & GetIndexMask(), std::memory_order_release);
+        consumer_wait_strategy_.Notify();
+
+        return count;
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    template<typename OutputIt>
+    std::size_t BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::DequeueBulk(OutputIt out, std::size_t max_count) {
+        const std::size_t head = LoadConsumerHead();
+
+        const std::size_t count = std::min(max_count, GetReadableSize(head, max_count));
+        if (!count) {
+            return 0;
+        }
+
+        const std::size_t first_segment_size = std::min(count, GetBufferSize() - head);
+
+        if constexpr (std::is_trivially_copyable_v<T> && std::contiguous_iterator<OutputIt>) {
+            T* elements = std::to_address(out);
+            std::memcpy(elements, &buffer_[head], first_segment_size * sizeof(T));
+            std::memcpy(elements + first_segment_size, &buffer_[0], (count - first_segment_size) * sizeof(T));
+        } else {
+            for (std::size_t i = 0; i < count; ++i, ++out) {
+                *out = std::move(*GetElement((head + i) & GetIndexMask()));
+            }
+            DestroyElements(head, count);
+        }
+
+        StoreConsumerHead((head + count) & GetIndexMask(), count);
+
+        return count;
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    std::span<T> BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::Reserve(std::size_t count) requires utils::IsTriviallyCopyable<T> {
+        const std::size_t tail = tail_.load(std::memory_order_acquire);
+        count = std::min({count, GetFreeSize(tail, count), GetBufferSize() - tail});
+        return {GetElement(tail), count};
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    void BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::Commit(std::size_t count) noexcept requires utils::IsTriviallyCopyable<T> {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        assert(count <= GetBufferSize() - tail); // Only the reserved slots can be committed
+        tail_.store((tail + count) & GetIndexMask(), std::memory_order_release);
+        consumer_wait_strategy_.Notify();
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    RingBufferSpan<T> BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::Peek(std::size_t max_count) {
+        const std::size_t head = LoadConsumerHead();
+
+        const std::size_t count = std::min(max_count, GetReadableSize(head, max_count));
+        const std::size_t first_segment_size = std::min(count, GetBufferSize() - head);
+
+        return {{GetElement(head), first_segment_size}, {GetElement(0), count - first_segment_size}};
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    void BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::Release(std::size_t count) noexcept {
+        const std::size_t head = LoadConsumerHead();
+        DestroyElements(head, count);
+        StoreConsumerHead((head + count) & GetIndexMask(), count);
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    bool BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::IsEmptyConsumer() {
         return !Front();
     }
 
-    template<typename T, std::size_t Capacity>
-    bool BoundedSPSCQueue<T, Capacity>::IsEmptyProducer() const noexcept {
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    bool BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::IsEmptyProducer() const noexcept {
         return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire);
     }
 
-    template<typename T, std::size_t Capacity>
-    std::size_t BoundedSPSCQueue<T, Capacity>::GetSize() const noexcept {
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    std::size_t BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::GetSize() const noexcept {
         std::ptrdiff_t size = tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
         if (size < 0) {
             size += GetBufferSize();
@@ -174,30 +491,129 @@ namespace concurrent::queue {
         return static_cast<std::size_t>(size);
     }
 
-    template<typename T, std::size_t Capacity>
-    std::size_t BoundedSPSCQueue<T, Capacity>::GetCapacity() const noexcept {
-        return GetBufferSize();
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    std::size_t BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::GetCapacity() const noexcept {
+        return GetBufferSize() - 1;
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    const Counters& BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::GetCounters() const noexcept {
+        return counters_;
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::~BoundedSPSCQueue() {
+        const std::size_t head = LoadConsumerHead();
+        DestroyElements(head, (tail_.load(std::memory_order_acquire) - head) & GetIndexMask());
     }
 
 
-    template<typename T, std::size_t Capacity>
-    constexpr std::size_t BoundedSPSCQueue<T, Capacity>::GetBufferSize() {
-        std::size_t capacity = Capacity + 1;
-        if (capacity < 4) {
-            capacity = 4;
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    T* BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::GetElement(std::size_t index) noexcept {
+        return std::launder(reinterpret_cast<T*>(&buffer_[index]));
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    void BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::DestroyElements(std::size_t index, std::size_t count) noexcept {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for (std::size_t i = 0; i < count; ++i) {
+                GetElement((index + i) & GetIndexMask())->~T();
+            }
         }
+    }
 
-        int max_bits_number = sizeof(std::size_t) * CHAR_BIT - 1;
-        capacity = 1 << (max_bits_number - __builtin_clzll(capacity) + 1);
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    std::size_t BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::GetBufferSize() const noexcept {
+        return buffer_.GetSize();
+    }
 
-        assert((capacity & (capacity - 1)) == 0); // is power of two
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    std::size_t BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::GetIndexMask() const noexcept {
+        return buffer_.GetIndexMask();
+    }
 
-        return capacity;
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    std::size_t BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::GetFreeSize(std::size_t tail, std::size_t required_count) {
+        std::size_t free_size = (cached_head_ - tail - 1) & GetIndexMask();
+        if (free_size < required_count) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            counters_.Add(instrumentation::Event::kCachedHeadRefresh);
+            free_size = (cached_head_ - tail - 1) & GetIndexMask();
+            if (free_size < required_count) {
+                RequestConsumerHead();
+            }
+        }
+        return free_size;
     }
 
-    template<typename T, std::size_t Capacity>
-    constexpr std::size_t BoundedSPSCQueue<T, Capacity>::GetIndexMask() {
-        return GetBufferSize() - 1;
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    std::size_t BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::GetReadableSize(std::size_t head, std::size_t required_count) {
+        std::size_t readable_size = (cached_tail_ - head) & GetIndexMask();
+        if (readable_size < required_count) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            counters_.Add(instrumentation::Event::kCachedTailRefresh);
+            readable_size = (cached_tail_ - head) & GetIndexMask();
+            if (!readable_size) {
+                FlushConsumerHead();
+            }
+        }
+        return readable_size;
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    constexpr bool BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::IsLazyHeadPublication() noexcept {
+        return HeadPublicationPeriod > kEagerHeadPublication;
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    std::size_t BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::LoadConsumerHead() const noexcept {
+        if constexpr (IsLazyHeadPublication()) {
+            return consumer_head_;
+        } else {
+            return head_.load(std::memory_order_relaxed);
+        }
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    void BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::StoreConsumerHead(std::size_t head, std::size_t released_count) noexcept {
+        if constexpr (IsLazyHeadPublication()) {
+            consumer_head_ = head;
+            unpublished_count_ += released_count;
+            if (unpublished_count_ >= HeadPublicationPeriod || is_head_requested_.load(std::memory_order_relaxed)) {
+                PublishConsumerHead();
+            }
+        } else {
+            head_.store(head, std::memory_order_release);
+            producer_wait_strategy_.Notify();
+        }
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    void BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::FlushConsumerHead() noexcept {
+        if constexpr (IsLazyHeadPublication()) {
+            if (unpublished_count_) {
+                PublishConsumerHead();
+            }
+        }
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    void BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::PublishConsumerHead() noexcept {
+        head_.store(consumer_head_, std::memory_order_release);
+        unpublished_count_ = 0;
+        if (is_head_requested_.load(std::memory_order_relaxed)) {
+            is_head_requested_.store(false, std::memory_order_relaxed);
+        }
+        producer_wait_strategy_.Notify();
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy, std::size_t HeadPublicationPeriod, typename Counters>
+    void BoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy, HeadPublicationPeriod, Counters>::RequestConsumerHead() noexcept {
+        if constexpr (IsLazyHeadPublication()) {
+            if (!is_head_requested_.load(std::memory_order_relaxed)) {
+                is_head_requested_.store(true, std::memory_order_relaxed);
+            }
+        }
     }
 
 } // End of namespace concurrent::queue
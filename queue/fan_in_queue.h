@@ -0,0 +1,241 @@
+#ifndef LOCK_FREE_FAN_IN_QUEUE_H
+#define LOCK_FREE_FAN_IN_QUEUE_H
+
+#include <memory>
+#include <atomic>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cassert>
+#include <utility>
+#include <iterator>
+#include <type_traits>
+
+#include "cache_line.h"
+#include "bounded_sp_sc_queue.h"
+
+namespace concurrent::queue {
+
+    // One consumer reads from QueuesCount BoundedSPSCQueue rings, every ring has its own producer.
+    // The producers set the bits of their rings in the packed ready bitmap, so the consumer finds the rings with data
+    // using countr_zero and does not touch the indices of the empty rings. The consumer clears the bit when the ring is empty.
+    // The rings are scanned round-robin, starting after the last read ring
+    template<typename T, std::size_t QueuesCount, std::size_t QueueCapacity, typename Allocator = std::allocator<T>>
+    class FanInQueue final {
+    public:
+        using Queue = BoundedSPSCQueue<T, QueueCapacity, Allocator>;
+
+        FanInQueue();
+        explicit FanInQueue(const Allocator& allocator);
+
+        FanInQueue(const FanInQueue&) = delete;
+        FanInQueue(FanInQueue&&) = delete;
+        FanInQueue& operator=(const FanInQueue&) = delete;
+        FanInQueue& operator=(FanInQueue&&) = delete;
+
+        // The producer methods. Only one thread can use each producer index
+        template<typename... Args>
+        bool Emplace(std::size_t producer, Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>);
+
+        template<typename = std::enable_if_t<std::is_copy_constructible_v<T>, bool>>
+        bool Enqueue(std::size_t producer, const T& element) noexcept(std::is_nothrow_copy_constructible_v<T>);
+
+        template<typename = std::enable_if_t<std::is_move_constructible_v<T>, bool>>
+        bool Enqueue(std::size_t producer, T&& element) noexcept(std::is_nothrow_move_constructible_v<T>);
+
+        // The consumer methods
+        template<typename = std::enable_if_t<std::is_copy_constructible_v<T> || std::is_move_constructible_v<T>, bool>>
+        bool Dequeue(T& element);
+
+        // Drains up to max_count elements from the ready rings. Every ring is drained with one DequeueBulk call.
+        // Returns the number of dequeued elements
+        template<std::random_access_iterator OutputIt>
+        std::size_t DequeueBulk(OutputIt out, std::size_t max_count);
+
+        [[nodiscard]] bool IsEmptyConsumer(); // IsEmpty method for consumer
+        [[nodiscard]] std::size_t GetQueuesCount() const noexcept;
+
+        ~FanInQueue() = default;
+
+    private:
+        using Word = std::uint64_t;
+
+        static constexpr std::size_t kBitsPerWord = 8 * sizeof(Word);
+        static constexpr std::size_t kWordsCount = (QueuesCount + kBitsPerWord - 1) / kBitsPerWord;
+
+        using Queues = std::array<Queue, QueuesCount>;
+        using ReadyBitmap = std::array<std::atomic<Word>, kWordsCount>;
+
+        template<std::size_t... Indices>
+        static Queues CreateQueues(const Allocator& allocator, std::index_sequence<Indices...>);
+
+        // Sets the bit of the ring after the element is published. The bit is not written if it is already set
+        void MarkReady(std::size_t queue) noexcept;
+
+        // Clears the bit of the empty ring. Returns false if the ring got the new elements in the meantime
+        bool ClearReady(std::size_t queue) noexcept;
+
+        // Returns the index of the first ready ring starting from the cursor or QueuesCount if there are no ready rings
+        std::size_t FindReadyQueue() const noexcept;
+
+    private:
+        static_assert(QueuesCount > 0, "The fan-in queue must have at least one ring");
+        static_assert(std::atomic<Word>::is_always_lock_free, "The ready bitmap must be lock free");
+
+        Queues queues_;
+
+        alignas(cache::kCacheLineSize) ReadyBitmap ready_{};
+
+        PADDING(padding0_, sizeof(ReadyBitmap));
+
+        alignas(cache::kCacheLineSize) std::size_t cursor_{0}; // Used only by consumer
+
+        PADDING(padding1_, sizeof(std::size_t));
+    };
+
+
+    // Implementation
+    template<typename T, std::size_t QueuesCount, std::size_t QueueCapacity, typename Allocator>
+    FanInQueue<T, QueuesCount, QueueCapacity, Allocator>::FanInQueue() : FanInQueue(Allocator()) {}
+
+    template<typename T, std::size_t QueuesCount, std::size_t QueueCapacity, typename Allocator>
+    FanInQueue<T, QueuesCount, QueueCapacity, Allocator>::FanInQueue(const Allocator& allocator)
+            : queues_(CreateQueues(allocator, std::make_index_sequence<QueuesCount>())) {}
+
+    template<typename T, std::size_t QueuesCount, std::size_t QueueCapacity, typename Allocator>
+    template<typename... Args>
+    bool FanInQueue<T, QueuesCount, QueueCapacity, Allocator>::Emplace(std::size_t producer, Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>) {
+        assert(producer < QueuesCount);
+        if (!queues_[producer].Emplace(std::forward<Args>(args)...)) {
+            return false;
+        }
+        MarkReady(producer);
+        return true;
+    }
+
+    template<typename T, std::size_t QueuesCount, std::size_t QueueCapacity, typename Allocator>
+    template<typename>
+    bool FanInQueue<T, QueuesCount, QueueCapacity, Allocator>::Enqueue(std::size_t producer, const T& element) noexcept(std::is_nothrow_copy_constructible_v<T>) {
+        return Emplace(producer, element);
+    }
+
+    template<typename T, std::size_t QueuesCount, std::size_t QueueCapacity, typename Allocator>
+    template<typename>
+    bool FanInQueue<T, QueuesCount, QueueCapacity, Allocator>::Enqueue(std::size_t producer, T&& element) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        return Emplace(producer, std::forward<T>(element));
+    }
+
+    template<typename T, std::size_t QueuesCount, std::size_t QueueCapacity, typename Allocator>
+    template<typename>
+    bool FanInQueue<T, QueuesCount, QueueCapacity, Allocator>::Dequeue(T& element) {
+        std::size_t queue = FindReadyQueue();
+        while (queue != QueuesCount) {
+            if (queues_[queue].Dequeue(element)) {
+                cursor_ = queue + 1 == QueuesCount ? 0 : queue + 1;
+                return true;
+            }
+            if (ClearReady(queue)) {
+                queue = FindReadyQueue();
+            }
+        }
+        return false;
+    }
+
+    template<typename T, std::size_t QueuesCount, std::size_t QueueCapacity, typename Allocator>
+    template<std::random_access_iterator OutputIt>
+    std::size_t FanInQueue<T, QueuesCount, QueueCapacity, Allocator>::DequeueBulk(OutputIt out, std::size_t max_count) {
+        std::size_t count = 0;
+        std::size_t queue = FindReadyQueue();
+        while (count < max_count && queue != QueuesCount) {
+            const std::size_t dequeued = queues_[queue].DequeueBulk(out + count, max_count - count);
+            count += dequeued;
+            cursor_ = queue + 1 == QueuesCount ? 0 : queue + 1;
+
+            if (!dequeued && !ClearReady(queue)) {
+                continue;
+            }
+            queue = FindReadyQueue();
+        }
+        return count;
+    }
+
+    template<typename T, std::size_t QueuesCount, std::size_t QueueCapacity, typename Allocator>
+    bool FanInQueue<T, QueuesCount, QueueCapacity, Allocator>::IsEmptyConsumer() {
+        std::size_t queue = FindReadyQueue();
+        while (queue != QueuesCount) {
+            if (!queues_[queue].IsEmptyConsumer()) {
+                return false;
+            }
+            if (ClearReady(queue)) {
+                queue = FindReadyQueue();
+            }
+        }
+        return true;
+    }
+
+    template<typename T, std::size_t QueuesCount, std::size_t QueueCapacity, typename Allocator>
+    std::size_t FanInQueue<T, QueuesCount, QueueCapacity, Allocator>::GetQueuesCount() const noexcept {
+        return QueuesCount;
+    }
+
+
+    template<typename T, std::size_t QueuesCount, std::size_t QueueCapacity, typename Allocator>
+    template<std::size_t... Indices>
+    typename FanInQueue<T, QueuesCount, QueueCapacity, Allocator>::Queues FanInQueue<T, QueuesCount, QueueCapacity, Allocator>::CreateQueues(
+            const Allocator& allocator, std::index_sequence<Indices...>) {
+        return {(static_cast<void>(Indices), Queue(allocator))...};
+    }
+
+    template<typename T, std::size_t QueuesCount, std::size_t QueueCapacity, typename Allocator>
+    void FanInQueue<T, QueuesCount, QueueCapacity, Allocator>::MarkReady(std::size_t queue) noexcept {
+        std::atomic<Word>& word = ready_[queue / kBitsPerWord];
+        const Word bit = Word{1} << (queue % kBitsPerWord);
+
+        // Orders the publication of the element before the load of the bit. Pairs with the fence in ClearReady
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!(word.load(std::memory_order_relaxed) & bit)) {
+            word.fetch_or(bit, std::memory_order_release);
+        }
+    }
+
+    template<typename T, std::size_t QueuesCount, std::size_t QueueCapacity, typename Allocator>
+    bool FanInQueue<T, QueuesCount, QueueCapacity, Allocator>::ClearReady(std::size_t queue) noexcept {
+        std::atomic<Word>& word = ready_[queue / kBitsPerWord];
+        const Word bit = Word{1} << (queue % kBitsPerWord);
+
+        word.fetch_and(~bit, std::memory_order_relaxed);
+
+        // Either the producer sees the cleared bit and sets it again, or the consumer sees the new element
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!queues_[queue].IsEmptyConsumer()) {
+            word.fetch_or(bit, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    template<typename T, std::size_t QueuesCount, std::size_t QueueCapacity, typename Allocator>
+    std::size_t FanInQueue<T, QueuesCount, QueueCapacity, Allocator>::FindReadyQueue() const noexcept {
+        const std::size_t first_word = cursor_ / kBitsPerWord;
+        const std::size_t first_bit = cursor_ % kBitsPerWord;
+
+        // The first word is scanned twice: the bits from the cursor first, and the bits before the cursor last
+        for (std::size_t i = 0; i <= kWordsCount; ++i) {
+            const std::size_t word_index = (first_word + i) % kWordsCount;
+            Word word = ready_[word_index].load(std::memory_order_acquire);
+            if (i == 0) {
+                word &= ~Word{0} << first_bit;
+            } else if (i == kWordsCount) {
+                word &= ~(~Word{0} << first_bit);
+            }
+
+            if (word) {
+                return word_index * kBitsPerWord + std::countr_zero(word);
+            }
+        }
+        return QueuesCount;
+    }
+
+} // End of namespace concurrent::queue
+
+#endif //LOCK_FREE_FAN_IN_QUEUE_H
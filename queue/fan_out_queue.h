@@ -0,0 +1,249 @@
+#ifndef LOCK_FREE_FAN_OUT_QUEUE_H
+#define LOCK_FREE_FAN_OUT_QUEUE_H
+
+#include <memory>
+#include <atomic>
+#include <array>
+#include <cassert>
+#include <utility>
+#include <iterator>
+#include <type_traits>
+
+#include "cache_line.h"
+#include "wait.h"
+#include "bounded_sp_sc_queue.h"
+
+namespace concurrent::queue {
+
+    // What the producer does, when the ring of the consumer is full
+    enum class SlowConsumerPolicy {
+        kBlock,      // Wait until the consumer reads the ring or disconnects
+        kDrop,       // Drop the message for this consumer and count it
+        kDisconnect  // Stop writing to this consumer
+    };
+
+    // Lossless single producer multiple consumers broadcast queue. Every consumer has its own BoundedSPSCQueue ring,
+    // the producer writes every message to all connected rings. Unlike BoundedMulticastQueue the messages are not
+    // overwritten, so a slow consumer holds up the producer according to the Policy. GetLag shows which consumer it is.
+    // With kBlock policy the producer waits for the full ring with the WaitStrategy, so it can park instead of spinning
+    template<typename T, std::size_t ConsumersCount, std::size_t QueueCapacity, SlowConsumerPolicy Policy = SlowConsumerPolicy::kBlock,
+             typename Allocator = std::allocator<T>, typename WaitStrategy = wait::BusySpinWaitStrategy>
+    class FanOutQueue final {
+    public:
+        using Queue = BoundedSPSCQueue<T, QueueCapacity, Allocator>;
+
+        FanOutQueue();
+        explicit FanOutQueue(const Allocator& allocator);
+
+        FanOutQueue(const FanOutQueue&) = delete;
+        FanOutQueue(FanOutQueue&&) = delete;
+        FanOutQueue& operator=(const FanOutQueue&) = delete;
+        FanOutQueue& operator=(FanOutQueue&&) = delete;
+
+        // The producer methods. Return the number of consumers, which received the message
+        template<typename = std::enable_if_t<std::is_copy_constructible_v<T>, bool>>
+        std::size_t Write(const T& message);
+
+        // Writes [first, last) to every connected ring with one EnqueueBulk call per ring, if the ring has enough space.
+        // With kDrop policy the messages, which do not fit, are dropped. With kDisconnect policy the consumer is
+        // disconnected after the messages, which fit, are written
+        template<std::forward_iterator InputIt>
+        std::size_t WriteBulk(InputIt first, InputIt last);
+
+        // The consumer methods. Only one thread can use each consumer index
+        bool Read(std::size_t consumer, T& message);
+
+        template<typename OutputIt>
+        std::size_t ReadBulk(std::size_t consumer, OutputIt out, std::size_t max_count);
+
+        // The consumer stops receiving the messages. It can still read the messages, which were written before.
+        // The producer blocked on this consumer continues
+        void Disconnect(std::size_t consumer) noexcept;
+
+        [[nodiscard]] bool IsConnected(std::size_t consumer) const noexcept;
+
+        // The number of messages written to the consumer, but not read yet
+        [[nodiscard]] std::size_t GetLag(std::size_t consumer) const noexcept;
+
+        // The connected consumer with the greatest lag
+        [[nodiscard]] std::size_t GetSlowestConsumer() const noexcept;
+
+        // The number of messages dropped for the consumer. Always 0 if the policy is not kDrop
+        [[nodiscard]] std::size_t GetDroppedCount(std::size_t consumer) const noexcept;
+
+        [[nodiscard]] std::size_t GetConsumersCount() const noexcept;
+
+        ~FanOutQueue() = default;
+
+    private:
+        using Queues = std::array<Queue, ConsumersCount>;
+
+        // Every consumer notifies the producer_wait_strategy_ of its state after the read, so the states are on the different
+        // cache lines. The producer writes the other fields only on the slow path
+        struct alignas(cache::kCacheLineSize) ConsumerState {
+            std::atomic<bool> is_connected_{true};
+            std::atomic<std::size_t> dropped_count_{0};
+            [[no_unique_address]] WaitStrategy producer_wait_strategy_; // The producer waits on it while the ring is full
+        };
+
+        template<std::size_t... Indices>
+        static Queues CreateQueues(const Allocator& allocator, std::index_sequence<Indices...>);
+
+        // Called by producer, when count messages do not fit in the ring of the consumer. With kBlock policy retries
+        // try_write, until it returns true or the consumer disconnects. Returns true if the messages are written
+        template<typename TryWrite>
+        bool OnFullQueue(std::size_t consumer, std::size_t count, TryWrite&& try_write);
+
+    private:
+        static_assert(ConsumersCount > 0, "The fan-out queue must have at least one consumer");
+
+        Queues queues_;
+
+        std::array<ConsumerState, ConsumersCount> consumers_{};
+    };
+
+
+    // Implementation
+    template<typename T, std::size_t ConsumersCount, std::size_t QueueCapacity, SlowConsumerPolicy Policy, typename Allocator, typename WaitStrategy>
+    FanOutQueue<T, ConsumersCount, QueueCapacity, Policy, Allocator, WaitStrategy>::FanOutQueue() : FanOutQueue(Allocator()) {}
+
+    template<typename T, std::size_t ConsumersCount, std::size_t QueueCapacity, SlowConsumerPolicy Policy, typename Allocator, typename WaitStrategy>
+    FanOutQueue<T, ConsumersCount, QueueCapacity, Policy, Allocator, WaitStrategy>::FanOutQueue(const Allocator& allocator)
+            : queues_(CreateQueues(allocator, std::make_index_sequence<ConsumersCount>())) {}
+
+    template<typename T, std::size_t ConsumersCount, std::size_t QueueCapacity, SlowConsumerPolicy Policy, typename Allocator, typename WaitStrategy>
+    template<typename>
+    std::size_t FanOutQueue<T, ConsumersCount, QueueCapacity, Policy, Allocator, WaitStrategy>::Write(const T& message) {
+        std::size_t received_count = 0;
+        for (std::size_t consumer = 0; consumer < ConsumersCount; ++consumer) {
+            if (!IsConnected(consumer)) {
+                continue;
+            }
+
+            const bool is_written = queues_[consumer].Enqueue(message) ||
+                                    OnFullQueue(consumer, 1, [&] { return queues_[consumer].Enqueue(message); });
+            received_count += is_written;
+        }
+        return received_count;
+    }
+
+    template<typename T, std::size_t ConsumersCount, std::size_t QueueCapacity, SlowConsumerPolicy Policy, typename Allocator, typename WaitStrategy>
+    template<std::forward_iterator InputIt>
+    std::size_t FanOutQueue<T, ConsumersCount, QueueCapacity, Policy, Allocator, WaitStrategy>::WriteBulk(InputIt first, InputIt last) {
+        const auto count = static_cast<std::size_t>(std::distance(first, last));
+
+        std::size_t received_count = 0;
+        for (std::size_t consumer = 0; consumer < ConsumersCount; ++consumer) {
+            if (!IsConnected(consumer)) {
+                continue;
+            }
+
+            std::size_t written_count = queues_[consumer].EnqueueBulk(first, last);
+            if (written_count < count) {
+                OnFullQueue(consumer, count - written_count, [&] {
+                    written_count += queues_[consumer].EnqueueBulk(std::next(first, static_cast<std::ptrdiff_t>(written_count)), last);
+                    return written_count == count;
+                });
+            }
+            received_count += written_count == count;
+        }
+        return received_count;
+    }
+
+    template<typename T, std::size_t ConsumersCount, std::size_t QueueCapacity, SlowConsumerPolicy Policy, typename Allocator, typename WaitStrategy>
+    bool FanOutQueue<T, ConsumersCount, QueueCapacity, Policy, Allocator, WaitStrategy>::Read(std::size_t consumer, T& message) {
+        assert(consumer < ConsumersCount);
+        if (!queues_[consumer].Dequeue(message)) {
+            return false;
+        }
+
+        // Only the producer with kBlock policy waits for the free space
+        if constexpr (Policy == SlowConsumerPolicy::kBlock) {
+            consumers_[consumer].producer_wait_strategy_.Notify();
+        }
+        return true;
+    }
+
+    template<typename T, std::size_t ConsumersCount, std::size_t QueueCapacity, SlowConsumerPolicy Policy, typename Allocator, typename WaitStrategy>
+    template<typename OutputIt>
+    std::size_t FanOutQueue<T, ConsumersCount, QueueCapacity, Policy, Allocator, WaitStrategy>::ReadBulk(std::size_t consumer, OutputIt out, std::size_t max_count) {
+        assert(consumer < ConsumersCount);
+        const std::size_t read_count = queues_[consumer].DequeueBulk(out, max_count);
+        if constexpr (Policy == SlowConsumerPolicy::kBlock) {
+            if (read_count) {
+                consumers_[consumer].producer_wait_strategy_.Notify();
+            }
+        }
+        return read_count;
+    }
+
+    template<typename T, std::size_t ConsumersCount, std::size_t QueueCapacity, SlowConsumerPolicy Policy, typename Allocator, typename WaitStrategy>
+    void FanOutQueue<T, ConsumersCount, QueueCapacity, Policy, Allocator, WaitStrategy>::Disconnect(std::size_t consumer) noexcept {
+        consumers_[consumer].is_connected_.store(false, std::memory_order_release);
+        if constexpr (Policy == SlowConsumerPolicy::kBlock) {
+            consumers_[consumer].producer_wait_strategy_.Notify();
+        }
+    }
+
+    template<typename T, std::size_t ConsumersCount, std::size_t QueueCapacity, SlowConsumerPolicy Policy, typename Allocator, typename WaitStrategy>
+    bool FanOutQueue<T, ConsumersCount, QueueCapacity, Policy, Allocator, WaitStrategy>::IsConnected(std::size_t consumer) const noexcept {
+        return consumers_[consumer].is_connected_.load(std::memory_order_acquire);
+    }
+
+    template<typename T, std::size_t ConsumersCount, std::size_t QueueCapacity, SlowConsumerPolicy Policy, typename Allocator, typename WaitStrategy>
+    std::size_t FanOutQueue<T, ConsumersCount, QueueCapacity, Policy, Allocator, WaitStrategy>::GetLag(std::size_t consumer) const noexcept {
+        return queues_[consumer].GetSize();
+    }
+
+    template<typename T, std::size_t ConsumersCount, std::size_t QueueCapacity, SlowConsumerPolicy Policy, typename Allocator, typename WaitStrategy>
+    std::size_t FanOutQueue<T, ConsumersCount, QueueCapacity, Policy, Allocator, WaitStrategy>::GetSlowestConsumer() const noexcept {
+        std::size_t slowest_consumer = 0;
+        std::size_t max_lag = 0;
+        for (std::size_t consumer = 0; consumer < ConsumersCount; ++consumer) {
+            const std::size_t lag = GetLag(consumer);
+            if (IsConnected(consumer) && lag > max_lag) {
+                slowest_consumer = consumer;
+                max_lag = lag;
+            }
+        }
+        return slowest_consumer;
+    }
+
+    template<typename T, std::size_t ConsumersCount, std::size_t QueueCapacity, SlowConsumerPolicy Policy, typename Allocator, typename WaitStrategy>
+    std::size_t FanOutQueue<T, ConsumersCount, QueueCapacity, Policy, Allocator, WaitStrategy>::GetDroppedCount(std::size_t consumer) const noexcept {
+        return consumers_[consumer].dropped_count_.load(std::memory_order_relaxed);
+    }
+
+    template<typename T, std::size_t ConsumersCount, std::size_t QueueCapacity, SlowConsumerPolicy Policy, typename Allocator, typename WaitStrategy>
+    std::size_t FanOutQueue<T, ConsumersCount, QueueCapacity, Policy, Allocator, WaitStrategy>::GetConsumersCount() const noexcept {
+        return ConsumersCount;
+    }
+
+
+    template<typename T, std::size_t ConsumersCount, std::size_t QueueCapacity, SlowConsumerPolicy Policy, typename Allocator, typename WaitStrategy>
+    template<std::size_t... Indices>
+    typename FanOutQueue<T, ConsumersCount, QueueCapacity, Policy, Allocator, WaitStrategy>::Queues FanOutQueue<T, ConsumersCount, QueueCapacity, Policy, Allocator, WaitStrategy>::CreateQueues(
+            const Allocator& allocator, std::index_sequence<Indices...>) {
+        return {(static_cast<void>(Indices), Queue(allocator))...};
+    }
+
+    template<typename T, std::size_t ConsumersCount, std::size_t QueueCapacity, SlowConsumerPolicy Policy, typename Allocator, typename WaitStrategy>
+    template<typename TryWrite>
+    bool FanOutQueue<T, ConsumersCount, QueueCapacity, Policy, Allocator, WaitStrategy>::OnFullQueue(std::size_t consumer, std::size_t count, TryWrite&& try_write) {
+        ConsumerState& state = consumers_[consumer];
+        if constexpr (Policy == SlowConsumerPolicy::kBlock) {
+            bool is_written = false;
+            state.producer_wait_strategy_.Wait([&] { return (is_written = try_write()) || !IsConnected(consumer); });
+            return is_written;
+        } else if constexpr (Policy == SlowConsumerPolicy::kDrop) {
+            state.dropped_count_.store(state.dropped_count_.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+            return false;
+        } else {
+            state.is_connected_.store(false, std::memory_order_release);
+            return false;
+        }
+    }
+
+} // End of namespace concurrent::queue
+
+#endif //LOCK_FREE_FAN_OUT_QUEUE_H
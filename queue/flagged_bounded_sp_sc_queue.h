@@ -0,0 +1,284 @@
+#ifndef LOCK_FREE_FLAGGED_BOUNDED_SP_SC_QUEUE_H
+#define LOCK_FREE_FLAGGED_BOUNDED_SP_SC_QUEUE_H
+
+#include <memory>
+#include <atomic>
+#include <type_traits>
+#include <utility>
+#include <new>
+
+#include "cache_line.h"
+#include "wait.h"
+#include "bounded_queue.h"
+
+namespace concurrent::queue {
+
+    namespace details {
+
+        // The element and the flag, which shows whether the element is constructed.
+        // The producer sets the flag after the construction, the consumer clears it after the destruction
+        template<typename T>
+        class FlaggedSPSCQueueSlot {
+        public:
+            FlaggedSPSCQueueSlot() = default;
+
+            FlaggedSPSCQueueSlot(const FlaggedSPSCQueueSlot&) = delete;
+            FlaggedSPSCQueueSlot& operator=(const FlaggedSPSCQueueSlot&) = delete;
+
+            T* GetElement() noexcept;
+
+            template<typename... Args>
+            void Construct(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>);
+
+            void Destroy() noexcept;
+
+            bool IsFull(std::memory_order order = std::memory_order_acquire) const noexcept;
+
+            ~FlaggedSPSCQueueSlot();
+
+        private:
+            std::aligned_storage_t<sizeof(T), alignof(T)> data_;
+            std::atomic<bool> is_full_{false};
+        };
+
+    }
+
+    // Single producer single consumer queue without the shared indices, in the style of FastFlow.
+    // Every slot has its own flag, so the producer and the consumer touch only the lines of the slots
+    // they write and read. The head and the tail are private, so the empty and the full checks do not
+    // move the index lines between the cores. The slots are not padded, so the small elements share the lines
+    template<typename T, std::size_t Capacity = kDynamicCapacity, typename Allocator = std::allocator<T>,
+             typename WaitStrategy = wait::BusySpinWaitStrategy>
+    class FlaggedBoundedSPSCQueue final {
+    public:
+        FlaggedBoundedSPSCQueue() requires (Capacity != kDynamicCapacity);
+        explicit FlaggedBoundedSPSCQueue(const Allocator& allocator) requires (Capacity != kDynamicCapacity);
+        explicit FlaggedBoundedSPSCQueue(std::size_t capacity, const Allocator& allocator = Allocator()) requires (Capacity == kDynamicCapacity);
+
+        FlaggedBoundedSPSCQueue(const FlaggedBoundedSPSCQueue&) = delete;
+        FlaggedBoundedSPSCQueue(FlaggedBoundedSPSCQueue&&) = delete;
+        FlaggedBoundedSPSCQueue& operator=(const FlaggedBoundedSPSCQueue&) = delete;
+        FlaggedBoundedSPSCQueue& operator=(FlaggedBoundedSPSCQueue&&) = delete;
+
+        T* Front();
+
+        template<typename... Args>
+        bool Emplace(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>);
+
+        template<typename = std::enable_if_t<std::is_copy_constructible_v<T>, bool>>
+        bool Enqueue(const T& element) noexcept(std::is_nothrow_copy_constructible_v<T>);
+
+        template<typename = std::enable_if_t<std::is_move_constructible_v<T>, bool>>
+        bool Enqueue(T&& element) noexcept(std::is_nothrow_move_constructible_v<T>);
+
+        bool Dequeue();
+
+        template<typename = std::enable_if_t<std::is_copy_constructible_v<T> || std::is_move_constructible_v<T>, bool>>
+        bool Dequeue(T& element);
+
+        // Blocking versions of Emplace, Enqueue and Dequeue. They wait with the WaitStrategy until the operation succeeds
+        template<typename... Args>
+        void BlockingEmplace(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>);
+
+        void BlockingEnqueue(const T& element) noexcept(std::is_nothrow_copy_constructible_v<T>);
+        void BlockingEnqueue(T&& element) noexcept(std::is_nothrow_move_constructible_v<T>);
+
+        void BlockingDequeue(T& element);
+
+        [[nodiscard]] bool IsEmptyConsumer(); // IsEmpty method for consumer
+        [[nodiscard]] bool IsFullProducer() const noexcept; // IsFull method for producer
+        [[nodiscard]] std::size_t GetCapacity() const noexcept;
+
+        ~FlaggedBoundedSPSCQueue() = default;
+
+    private:
+        using Slot = details::FlaggedSPSCQueueSlot<T>;
+        using SlotAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Slot>;
+        using Buffer = details::RingBuffer<Slot, Capacity == kDynamicCapacity ? kDynamicCapacity : details::GetBufferSize(Capacity), SlotAllocator>;
+
+        std::size_t GetIndexMask() const noexcept;
+
+    private:
+        PADDING(padding0_, 0);
+
+        Buffer buffer_;
+
+        PADDING(padding1_, sizeof(Buffer));
+
+        alignas(cache::kCacheLineSize) std::size_t tail_{0}; // Used only by producer
+
+        PADDING(padding2_, sizeof(std::size_t));
+
+        alignas(cache::kCacheLineSize) std::size_t head_{0}; // Used only by consumer
+
+        PADDING(padding3_, sizeof(std::size_t));
+
+        [[no_unique_address]] WaitStrategy producer_wait_strategy_; // The producer waits on it while the queue is full
+        [[no_unique_address]] WaitStrategy consumer_wait_strategy_; // The consumer waits on it while the queue is empty
+    };
+
+
+    // Implementation
+
+    namespace details {
+
+        template<typename T>
+        T* FlaggedSPSCQueueSlot<T>::GetElement() noexcept {
+            return std::launder(reinterpret_cast<T*>(&data_));
+        }
+
+        template<typename T>
+        template<typename... Args>
+        void FlaggedSPSCQueueSlot<T>::Construct(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>) {
+            new (&data_) T(std::forward<Args>(args)...);
+            is_full_.store(true, std::memory_order_release);
+        }
+
+        template<typename T>
+        void FlaggedSPSCQueueSlot<T>::Destroy() noexcept {
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+                GetElement()->~T();
+            }
+            is_full_.store(false, std::memory_order_release);
+        }
+
+        template<typename T>
+        bool FlaggedSPSCQueueSlot<T>::IsFull(std::memory_order order) const noexcept {
+            return is_full_.load(order);
+        }
+
+        template<typename T>
+        FlaggedSPSCQueueSlot<T>::~FlaggedSPSCQueueSlot() {
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+                if (IsFull()) {
+                    GetElement()->~T();
+                }
+            }
+        }
+
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    FlaggedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy>::FlaggedBoundedSPSCQueue() requires (Capacity != kDynamicCapacity) : FlaggedBoundedSPSCQueue(Allocator()) {}
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    FlaggedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy>::FlaggedBoundedSPSCQueue(const Allocator& allocator) requires (Capacity != kDynamicCapacity)
+            : buffer_(SlotAllocator(allocator)) {}
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    FlaggedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy>::FlaggedBoundedSPSCQueue(std::size_t capacity, const Allocator& allocator) requires (Capacity == kDynamicCapacity)
+            : buffer_(details::GetBufferSize(capacity), SlotAllocator(allocator)) {}
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    T* FlaggedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy>::Front() {
+        Slot& slot = buffer_[head_];
+        return slot.IsFull() ? slot.GetElement() : nullptr;
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    template<typename... Args>
+    bool FlaggedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy>::Emplace(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>) {
+        Slot& slot = buffer_[tail_];
+        if (slot.IsFull()) {
+            return false;
+        }
+
+        slot.Construct(std::forward<Args>(args)...);
+        tail_ = (tail_ + 1) & GetIndexMask();
+        consumer_wait_strategy_.Notify();
+
+        return true;
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    template<typename>
+    bool FlaggedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy>::Enqueue(const T& element) noexcept(std::is_nothrow_copy_constructible_v<T>) {
+        return Emplace(element);
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    template<typename>
+    bool FlaggedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy>::Enqueue(T&& element) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        return Emplace(std::forward<T>(element));
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    bool FlaggedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy>::Dequeue() {
+        Slot& slot = buffer_[head_];
+        if (!slot.IsFull()) {
+            return false;
+        }
+
+        slot.Destroy();
+        head_ = (head_ + 1) & GetIndexMask();
+        producer_wait_strategy_.Notify();
+
+        return true;
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    template<typename>
+    bool FlaggedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy>::Dequeue(T& element) {
+        Slot& slot = buffer_[head_];
+        if (!slot.IsFull()) {
+            return false;
+        }
+
+        if constexpr (std::is_move_constructible_v<T>) {
+            element = std::move(*slot.GetElement());
+        } else {
+            element = *slot.GetElement();
+        }
+
+        slot.Destroy();
+        head_ = (head_ + 1) & GetIndexMask();
+        producer_wait_strategy_.Notify();
+
+        return true;
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    template<typename... Args>
+    void FlaggedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy>::BlockingEmplace(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>) {
+        producer_wait_strategy_.Wait([&] { return Emplace(std::forward<Args>(args)...); });
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    void FlaggedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy>::BlockingEnqueue(const T& element) noexcept(std::is_nothrow_copy_constructible_v<T>) {
+        BlockingEmplace(element);
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    void FlaggedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy>::BlockingEnqueue(T&& element) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        BlockingEmplace(std::move(element));
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    void FlaggedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy>::BlockingDequeue(T& element) {
+        consumer_wait_strategy_.Wait([&] { return Dequeue(element); });
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    bool FlaggedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy>::IsEmptyConsumer() {
+        return !Front();
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    bool FlaggedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy>::IsFullProducer() const noexcept {
+        return buffer_[tail_].IsFull();
+    }
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    std::size_t FlaggedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy>::GetCapacity() const noexcept {
+        return buffer_.GetSize(); // There is no empty cell, all slots can be full
+    }
+
+
+    template<typename T, std::size_t Capacity, typename Allocator, typename WaitStrategy>
+    std::size_t FlaggedBoundedSPSCQueue<T, Capacity, Allocator, WaitStrategy>::GetIndexMask() const noexcept {
+        return buffer_.GetIndexMask();
+    }
+
+} // End of namespace concurrent::queue
+
+#endif //LOCK_FREE_FLAGGED_BOUNDED_SP_SC_QUEUE_H
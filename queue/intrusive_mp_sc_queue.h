@@ -0,0 +1,135 @@
+#ifndef LOCK_FREE_INTRUSIVE_MP_SC_QUEUE_H
+#define LOCK_FREE_INTRUSIVE_MP_SC_QUEUE_H
+
+#include <atomic>
+#include <concepts>
+
+#include "cache_line.h"
+#include "wait.h"
+
+namespace concurrent::queue {
+
+    // The messages of IntrusiveMPSCQueue inherit the node, so the queue does not allocate memory.
+    // The link is not a part of the message, so it is not copied with the message
+    struct IntrusiveMPSCQueueNode {
+        IntrusiveMPSCQueueNode() = default;
+        IntrusiveMPSCQueueNode(const IntrusiveMPSCQueueNode&) noexcept {}
+        IntrusiveMPSCQueueNode& operator=(const IntrusiveMPSCQueueNode&) noexcept { return *this; }
+
+        std::atomic<IntrusiveMPSCQueueNode*> next_{nullptr};
+    };
+
+    // Vyukov's intrusive MPSC queue. The producers link the node with one exchange of tail_ and one store,
+    // so they are wait-free. The consumer follows the next pointers from head_ without the atomic RMW operations.
+    // The stub node lets the consumer take the last node without the race with the producers.
+    // The queue does not own the nodes: the node must live until it is dequeued and must not be enqueued twice.
+    // The producer, which exchanged tail_ but did not link the node yet, hides its node and the nodes after it
+    // from the consumer, so TryDequeue can return nullptr while the queue is not empty
+    template<typename T, typename WaitStrategy = wait::BusySpinWaitStrategy> requires std::derived_from<T, IntrusiveMPSCQueueNode>
+    class IntrusiveMPSCQueue {
+    public:
+        IntrusiveMPSCQueue();
+
+        IntrusiveMPSCQueue(const IntrusiveMPSCQueue&) = delete;
+        IntrusiveMPSCQueue(IntrusiveMPSCQueue&&) = delete;
+        IntrusiveMPSCQueue& operator=(const IntrusiveMPSCQueue&) = delete;
+        IntrusiveMPSCQueue& operator=(IntrusiveMPSCQueue&&) = delete;
+
+        // Producer method. Never waits
+        void Enqueue(T* message) noexcept;
+
+        // Consumer methods. Dequeue waits with the WaitStrategy for the next message
+        T* Dequeue() noexcept;
+        T* TryDequeue() noexcept;
+
+        [[nodiscard]] bool IsEmpty() const noexcept; // IsEmpty method for consumer
+
+        ~IntrusiveMPSCQueue() = default;
+
+    private:
+        using Node = IntrusiveMPSCQueueNode;
+
+        void Push(Node* node) noexcept;
+
+    private:
+        alignas(cache::kCacheLineSize) std::atomic<Node*> tail_;
+
+        PADDING(padding0_, sizeof(std::atomic<Node*>));
+
+        alignas(cache::kCacheLineSize) Node* head_;
+        Node stub_;
+
+        PADDING(padding1_, sizeof(Node*) + sizeof(Node));
+
+        [[no_unique_address]] WaitStrategy wait_strategy_; // The consumer waits on it for the next message
+    };
+
+
+    // Implementation
+    template<typename T, typename WaitStrategy> requires std::derived_from<T, IntrusiveMPSCQueueNode>
+    IntrusiveMPSCQueue<T, WaitStrategy>::IntrusiveMPSCQueue() : tail_(&stub_), head_(&stub_) {}
+
+    template<typename T, typename WaitStrategy> requires std::derived_from<T, IntrusiveMPSCQueueNode>
+    void IntrusiveMPSCQueue<T, WaitStrategy>::Enqueue(T* message) noexcept {
+        Push(message);
+        wait_strategy_.Notify();
+    }
+
+    template<typename T, typename WaitStrategy> requires std::derived_from<T, IntrusiveMPSCQueueNode>
+    T* IntrusiveMPSCQueue<T, WaitStrategy>::Dequeue() noexcept {
+        T* message = nullptr;
+        wait_strategy_.Wait([&] { return (message = TryDequeue()) != nullptr; });
+        return message;
+    }
+
+    template<typename T, typename WaitStrategy> requires std::derived_from<T, IntrusiveMPSCQueueNode>
+    T* IntrusiveMPSCQueue<T, WaitStrategy>::TryDequeue() noexcept {
+        Node* head = head_;
+        Node* next = head->next_.load(std::memory_order_acquire);
+
+        // Skips the stub node
+        if (head == &stub_) {
+            if (!next) {
+                return nullptr;
+            }
+            head_ = next;
+            head = next;
+            next = next->next_.load(std::memory_order_acquire);
+        }
+
+        if (next) {
+            head_ = next;
+            return static_cast<T*>(head);
+        }
+
+        // The head is the last linked node. If it is not the tail, the producer has not linked its node yet
+        if (head != tail_.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+
+        // Pushes the stub node after the head, so the head can be taken without leaving the list empty
+        Push(&stub_);
+
+        next = head->next_.load(std::memory_order_acquire);
+        if (next) {
+            head_ = next;
+            return static_cast<T*>(head);
+        }
+        return nullptr;
+    }
+
+    template<typename T, typename WaitStrategy> requires std::derived_from<T, IntrusiveMPSCQueueNode>
+    bool IntrusiveMPSCQueue<T, WaitStrategy>::IsEmpty() const noexcept {
+        return head_ == &stub_ && !stub_.next_.load(std::memory_order_acquire);
+    }
+
+    template<typename T, typename WaitStrategy> requires std::derived_from<T, IntrusiveMPSCQueueNode>
+    void IntrusiveMPSCQueue<T, WaitStrategy>::Push(Node* node) noexcept {
+        node->next_.store(nullptr, std::memory_order_relaxed);
+        Node* prev = tail_.exchange(node, std::memory_order_acq_rel);
+        prev->next_.store(node, std::memory_order_release);
+    }
+
+} // End of namespace concurrent::queue
+
+#endif //LOCK_FREE_INTRUSIVE_MP_SC_QUEUE_H
@@ -0,0 +1,421 @@
+#ifndef LOCK_FREE_SHARDED_MP_MC_QUEUE_H
+#define LOCK_FREE_SHARDED_MP_MC_QUEUE_H
+
+#include <memory>
+#include <atomic>
+#include <vector>
+#include <thread>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+#include <cstdint>
+#include <cstddef>
+
+#include "cache_line.h"
+#include "wait.h"
+#include "random.h"
+#include "bounded_mp_mc_queue.h"
+
+namespace concurrent::queue {
+
+    namespace details {
+
+        // The home shard of the thread in the last sharded queue, which it used without the token, and its random generator
+        struct ShardedQueueThreadContext {
+            ShardedQueueThreadContext();
+
+            std::uint64_t queue_id_{0}; // The queue, to which home_shard_ belongs. The ids start from 1
+            std::size_t home_shard_{0};
+            utils::XorShift64Random random_;
+        };
+
+        // The unique ids of the sharded queues. The id is not reused, so the context cannot take the new queue
+        // at the address of the destroyed one for the old one
+        std::uint64_t GetNextShardedQueueId() noexcept;
+
+        // Seeds the random generators of the threads and the tokens
+        std::uint64_t GetNextShardedQueueSeed() noexcept;
+
+        ShardedQueueThreadContext& GetShardedQueueThreadContext();
+
+    }
+
+    // The queue of ShardsCount BoundedMPMCQueue shards, which gives up the global FIFO order for the scalability.
+    // Every thread enqueues to its home shard and dequeues from it first, so the threads of the different shards
+    // do not touch the same head_ and tail_. If the home shard is empty (full), the thread probes the other shards,
+    // starting from the random one. The elements of one producer are dequeued in order only from one shard.
+    // The queue gives the home shards to the threads round-robin in the order of their first call. The thread, which uses
+    // several sharded queues in turn, gets the new home shard on every switch, so it should use the Token, which also lets
+    // the producer and the consumer choose the same shard.
+    // Emplace and Enqueue wait on the home shard, when all shards are full. Dequeue waits with the WaitStrategy
+    template<typename T, typename Allocator = std::allocator<T>, typename WaitStrategy = wait::BusySpinWaitStrategy>
+    class ShardedMPMCQueue {
+    public:
+        explicit ShardedMPMCQueue(std::size_t shard_capacity, std::size_t shards_count = std::thread::hardware_concurrency(),
+                                  const Allocator& allocator = Allocator());
+
+        ShardedMPMCQueue(const ShardedMPMCQueue&) = delete;
+        ShardedMPMCQueue(ShardedMPMCQueue&&) = delete;
+        ShardedMPMCQueue& operator=(const ShardedMPMCQueue&) = delete;
+        ShardedMPMCQueue& operator=(ShardedMPMCQueue&&) = delete;
+
+        template<typename... Args, typename = std::enable_if_t<std::is_nothrow_constructible_v<T, Args...>, bool>>
+        void Emplace(Args&&... args) noexcept;
+
+        template<typename... Args, typename = std::enable_if_t<std::is_nothrow_constructible_v<T, Args...>, bool>>
+        bool TryEmplace(Args&&... args) noexcept;
+
+        template<typename = std::enable_if_t<std::is_nothrow_copy_constructible_v<T>, bool>>
+        void Enqueue(const T& element) noexcept;
+
+        template<typename = std::enable_if_t<std::is_nothrow_copy_constructible_v<T>, bool>>
+        bool TryEnqueue(const T& element) noexcept;
+
+        template<typename = std::enable_if_t<std::is_nothrow_move_constructible_v<T>, bool>>
+        void Enqueue(T&& element) noexcept;
+
+        template<typename = std::enable_if_t<std::is_nothrow_move_constructible_v<T>, bool>>
+        bool TryEnqueue(T&& element) noexcept;
+
+
+        template<typename = std::enable_if_t<std::is_copy_constructible_v<T> || std::is_move_constructible_v<T>, bool>>
+        void Dequeue(T& element);
+
+        template<typename = std::enable_if_t<std::is_copy_constructible_v<T> || std::is_move_constructible_v<T>, bool>>
+        bool TryDequeue(T& element);
+
+
+        [[nodiscard]] std::size_t GetSize() const noexcept;
+        [[nodiscard]] bool IsEmpty() const noexcept;
+        [[nodiscard]] std::size_t GetCapacity() const noexcept;
+        [[nodiscard]] std::size_t GetShardsCount() const noexcept;
+
+        ~ShardedMPMCQueue() = default;
+
+        // The home shard of one thread in this queue. Without home_shard the token takes the next shard round-robin.
+        // The producer and the consumer, which pass the same home_shard, work on one shard, while it is not empty (full)
+        class Token {
+        private:
+            using Queue = ShardedMPMCQueue<T, Allocator, WaitStrategy>;
+
+        public:
+            explicit Token(Queue* queue);
+            Token(Queue* queue, std::size_t home_shard);
+
+            Token(const Token&) = delete;
+            Token(Token&&) = delete;
+            Token& operator=(const Token&) = delete;
+            Token& operator=(Token&&) = delete;
+
+            template<typename... Args, typename = std::enable_if_t<std::is_nothrow_constructible_v<T, Args...>, bool>>
+            void Emplace(Args&&... args) noexcept;
+
+            template<typename... Args, typename = std::enable_if_t<std::is_nothrow_constructible_v<T, Args...>, bool>>
+            bool TryEmplace(Args&&... args) noexcept;
+
+            template<typename = std::enable_if_t<std::is_nothrow_copy_constructible_v<T>, bool>>
+            void Enqueue(const T& element) noexcept;
+
+            template<typename = std::enable_if_t<std::is_nothrow_copy_constructible_v<T>, bool>>
+            bool TryEnqueue(const T& element) noexcept;
+
+            template<typename = std::enable_if_t<std::is_nothrow_move_constructible_v<T>, bool>>
+            void Enqueue(T&& element) noexcept;
+
+            template<typename = std::enable_if_t<std::is_nothrow_move_constructible_v<T>, bool>>
+            bool TryEnqueue(T&& element) noexcept;
+
+            template<typename = std::enable_if_t<std::is_copy_constructible_v<T> || std::is_move_constructible_v<T>, bool>>
+            void Dequeue(T& element);
+
+            template<typename = std::enable_if_t<std::is_copy_constructible_v<T> || std::is_move_constructible_v<T>, bool>>
+            bool TryDequeue(T& element);
+
+            [[nodiscard]] std::size_t GetHomeShard() const noexcept;
+
+            ~Token() = default;
+
+        private:
+            Queue* queue_;
+            std::size_t home_shard_;
+            utils::XorShift64Random random_;
+        };
+
+        friend class Token;
+
+    private:
+        // The shards do not wait on their WaitStrategy: the blocking operations of the shards are used only when
+        // all shards are full, and the consumers wait on wait_strategy_ of the queue
+        using Shard = BoundedMPMCQueue<T, kDynamicCapacity, Allocator, wait::BusySpinWaitStrategy>;
+
+        // Returns the context of the current thread with its home shard in this queue
+        details::ShardedQueueThreadContext& GetThreadContext() noexcept;
+
+        std::size_t GetNextHomeShard() noexcept;
+
+        // The operations from the home shard with the random generator of the thread or the token
+        template<typename... Args>
+        void EmplaceFrom(std::size_t home_shard, utils::XorShift64Random& random, Args&&... args) noexcept;
+
+        template<typename... Args>
+        bool TryEmplaceFrom(std::size_t home_shard, utils::XorShift64Random& random, Args&&... args) noexcept;
+
+        void DequeueFrom(std::size_t home_shard, utils::XorShift64Random& random, T& element);
+        bool TryDequeueFrom(std::size_t home_shard, utils::XorShift64Random& random, T& element);
+
+        // Calls try_operation for the home shard, and then for the other shards starting from the random one,
+        // until it returns true
+        template<typename TryOperation>
+        bool ForEachShard(std::size_t home_shard, utils::XorShift64Random& random, TryOperation&& try_operation);
+
+    private:
+        std::vector<std::unique_ptr<Shard>> shards_;
+        const std::uint64_t id_;
+
+        alignas(cache::kCacheLineSize) std::atomic<std::size_t> next_home_shard_{0}; // Touched only on the assignment
+
+        PADDING(padding0_, sizeof(std::atomic<std::size_t>));
+
+        [[no_unique_address]] WaitStrategy wait_strategy_; // Consumers wait on it for the new elements
+    };
+
+
+    // Implementation
+    namespace details {
+
+        inline std::uint64_t GetNextShardedQueueId() noexcept {
+            static std::atomic<std::uint64_t> queues_count{0};
+            return queues_count.fetch_add(1, std::memory_order_relaxed) + 1;
+        }
+
+        inline std::uint64_t GetNextShardedQueueSeed() noexcept {
+            static std::atomic<std::uint64_t> seeds_count{0};
+            return 2 * seeds_count.fetch_add(1, std::memory_order_relaxed) + 1;
+        }
+
+        inline ShardedQueueThreadContext::ShardedQueueThreadContext() : random_(GetNextShardedQueueSeed()) {}
+
+        inline ShardedQueueThreadContext& GetShardedQueueThreadContext() {
+            static thread_local ShardedQueueThreadContext context;
+            return context;
+        }
+
+    }
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    ShardedMPMCQueue<T, Allocator, WaitStrategy>::ShardedMPMCQueue(std::size_t shard_capacity, std::size_t shards_count, const Allocator& allocator)
+            : id_(details::GetNextShardedQueueId()) {
+        shards_count = std::max<std::size_t>(shards_count, 1);
+
+        shards_.reserve(shards_count);
+        for (std::size_t i = 0; i < shards_count; ++i) {
+            shards_.emplace_back(std::make_unique<Shard>(shard_capacity, allocator));
+        }
+    }
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    template<typename... Args, typename>
+    void ShardedMPMCQueue<T, Allocator, WaitStrategy>::Emplace(Args&&... args) noexcept {
+        details::ShardedQueueThreadContext& context = GetThreadContext();
+        EmplaceFrom(context.home_shard_, context.random_, std::forward<Args>(args)...);
+    }
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    template<typename... Args, typename>
+    bool ShardedMPMCQueue<T, Allocator, WaitStrategy>::TryEmplace(Args&&... args) noexcept {
+        details::ShardedQueueThreadContext& context = GetThreadContext();
+        return TryEmplaceFrom(context.home_shard_, context.random_, std::forward<Args>(args)...);
+    }
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    template<typename>
+    void ShardedMPMCQueue<T, Allocator, WaitStrategy>::Enqueue(const T& element) noexcept {
+        Emplace(element);
+    }
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    template<typename>
+    bool ShardedMPMCQueue<T, Allocator, WaitStrategy>::TryEnqueue(const T& element) noexcept {
+        return TryEmplace(element);
+    }
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    template<typename>
+    void ShardedMPMCQueue<T, Allocator, WaitStrategy>::Enqueue(T&& element) noexcept {
+        Emplace(std::forward<T>(element));
+    }
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    template<typename>
+    bool ShardedMPMCQueue<T, Allocator, WaitStrategy>::TryEnqueue(T&& element) noexcept {
+        return TryEmplace(std::forward<T>(element));
+    }
+
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    template<typename>
+    void ShardedMPMCQueue<T, Allocator, WaitStrategy>::Dequeue(T& element) {
+        details::ShardedQueueThreadContext& context = GetThreadContext();
+        DequeueFrom(context.home_shard_, context.random_, element);
+    }
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    template<typename>
+    bool ShardedMPMCQueue<T, Allocator, WaitStrategy>::TryDequeue(T& element) {
+        details::ShardedQueueThreadContext& context = GetThreadContext();
+        return TryDequeueFrom(context.home_shard_, context.random_, element);
+    }
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    std::size_t ShardedMPMCQueue<T, Allocator, WaitStrategy>::GetSize() const noexcept {
+        std::size_t size = 0;
+        for (const auto& shard : shards_) {
+            size += shard->GetSize();
+        }
+        return size;
+    }
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    bool ShardedMPMCQueue<T, Allocator, WaitStrategy>::IsEmpty() const noexcept {
+        return std::all_of(shards_.begin(), shards_.end(), [](const auto& shard) { return shard->IsEmpty(); });
+    }
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    std::size_t ShardedMPMCQueue<T, Allocator, WaitStrategy>::GetCapacity() const noexcept {
+        return shards_.size() * shards_.front()->GetCapacity();
+    }
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    std::size_t ShardedMPMCQueue<T, Allocator, WaitStrategy>::GetShardsCount() const noexcept {
+        return shards_.size();
+    }
+
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    details::ShardedQueueThreadContext& ShardedMPMCQueue<T, Allocator, WaitStrategy>::GetThreadContext() noexcept {
+        details::ShardedQueueThreadContext& context = details::GetShardedQueueThreadContext();
+        if (context.queue_id_ != id_) {
+            context.queue_id_ = id_;
+            context.home_shard_ = GetNextHomeShard();
+        }
+        return context;
+    }
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    std::size_t ShardedMPMCQueue<T, Allocator, WaitStrategy>::GetNextHomeShard() noexcept {
+        return next_home_shard_.fetch_add(1, std::memory_order_relaxed) % shards_.size();
+    }
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    template<typename... Args>
+    void ShardedMPMCQueue<T, Allocator, WaitStrategy>::EmplaceFrom(std::size_t home_shard, utils::XorShift64Random& random, Args&&... args) noexcept {
+        if (!TryEmplaceFrom(home_shard, random, std::forward<Args>(args)...)) {
+            shards_[home_shard]->Emplace(std::forward<Args>(args)...);
+            wait_strategy_.Notify();
+        }
+    }
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    template<typename... Args>
+    bool ShardedMPMCQueue<T, Allocator, WaitStrategy>::TryEmplaceFrom(std::size_t home_shard, utils::XorShift64Random& random, Args&&... args) noexcept {
+        if (ForEachShard(home_shard, random, [&](Shard& shard) { return shard.TryEmplace(std::forward<Args>(args)...); })) {
+            wait_strategy_.Notify();
+            return true;
+        }
+        return false;
+    }
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    void ShardedMPMCQueue<T, Allocator, WaitStrategy>::DequeueFrom(std::size_t home_shard, utils::XorShift64Random& random, T& element) {
+        wait_strategy_.Wait([&] { return TryDequeueFrom(home_shard, random, element); });
+    }
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    bool ShardedMPMCQueue<T, Allocator, WaitStrategy>::TryDequeueFrom(std::size_t home_shard, utils::XorShift64Random& random, T& element) {
+        return ForEachShard(home_shard, random, [&](Shard& shard) { return shard.TryDequeue(element); });
+    }
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    template<typename TryOperation>
+    bool ShardedMPMCQueue<T, Allocator, WaitStrategy>::ForEachShard(std::size_t home_shard, utils::XorShift64Random& random, TryOperation&& try_operation) {
+        if (try_operation(*shards_[home_shard])) {
+            return true;
+        }
+
+        // The other shards in the order of the random offset from the home shard
+        const std::size_t shards_count = shards_.size();
+        const std::size_t first_offset = shards_count > 1 ? static_cast<std::size_t>(random.Next() % (shards_count - 1)) : 0;
+        for (std::size_t i = 0; i + 1 < shards_count; ++i) {
+            const std::size_t offset = 1 + (first_offset + i) % (shards_count - 1);
+            if (try_operation(*shards_[(home_shard + offset) % shards_count])) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+
+    // Token
+    template<typename T, typename Allocator, typename WaitStrategy>
+    ShardedMPMCQueue<T, Allocator, WaitStrategy>::Token::Token(Queue* queue) : Token(queue, queue->GetNextHomeShard()) {}
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    ShardedMPMCQueue<T, Allocator, WaitStrategy>::Token::Token(Queue* queue, std::size_t home_shard)
+            : queue_(queue), home_shard_(home_shard % queue->GetShardsCount()), random_(details::GetNextShardedQueueSeed()) {}
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    template<typename... Args, typename>
+    void ShardedMPMCQueue<T, Allocator, WaitStrategy>::Token::Emplace(Args&&... args) noexcept {
+        queue_->EmplaceFrom(home_shard_, random_, std::forward<Args>(args)...);
+    }
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    template<typename... Args, typename>
+    bool ShardedMPMCQueue<T, Allocator, WaitStrategy>::Token::TryEmplace(Args&&... args) noexcept {
+        return queue_->TryEmplaceFrom(home_shard_, random_, std::forward<Args>(args)...);
+    }
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    template<typename>
+    void ShardedMPMCQueue<T, Allocator, WaitStrategy>::Token::Enqueue(const T& element) noexcept {
+        Emplace(element);
+    }
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    template<typename>
+    bool ShardedMPMCQueue<T, Allocator, WaitStrategy>::Token::TryEnqueue(const T& element) noexcept {
+        return TryEmplace(element);
+    }
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    template<typename>
+    void ShardedMPMCQueue<T, Allocator, WaitStrategy>::Token::Enqueue(T&& element) noexcept {
+        Emplace(std::forward<T>(element));
+    }
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    template<typename>
+    bool ShardedMPMCQueue<T, Allocator, WaitStrategy>::Token::TryEnqueue(T&& element) noexcept {
+        return TryEmplace(std::forward<T>(element));
+    }
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    template<typename>
+    void ShardedMPMCQueue<T, Allocator, WaitStrategy>::Token::Dequeue(T& element) {
+        queue_->DequeueFrom(home_shard_, random_, element);
+    }
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    template<typename>
+    bool ShardedMPMCQueue<T, Allocator, WaitStrategy>::Token::TryDequeue(T& element) {
+        return queue_->TryDequeueFrom(home_shard_, random_, element);
+    }
+
+    template<typename T, typename Allocator, typename WaitStrategy>
+    std::size_t ShardedMPMCQueue<T, Allocator, WaitStrategy>::Token::GetHomeShard() const noexcept {
+        return home_shard_;
+    }
+
+} // End of namespace concurrent::queue
+
+#endif //LOCK_FREE_SHARDED_MP_MC_QUEUE_H
@@ -0,0 +1,325 @@
+#ifndef LOCK_FREE_SHARED_MEMORY_SP_SC_QUEUE_H
+#define LOCK_FREE_SHARED_MEMORY_SP_SC_QUEUE_H
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <cerrno>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <bit>
+#include <new>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "cache_line.h"
+#include "utils.h"
+#include "bounded_queue.h"
+
+namespace concurrent::queue {
+
+    namespace details {
+
+        inline constexpr std::uint64_t kSharedMemoryQueueMagic = 0x5350'5343'5155'4555; // "SPSCQUEU"
+        inline constexpr std::uint32_t kSharedMemoryQueueLayoutVersion = 1;
+
+        // Lives at the beginning of the shared memory region. The ring buffer follows it
+        struct SharedMemorySPSCQueueHeader {
+            std::atomic<std::uint64_t> magic_{0}; // Stored last by the creator, so the header is initialized if it is valid
+            std::uint32_t version_{0};
+            std::uint32_t element_size_{0};
+            std::uint64_t buffer_size_{0};
+
+            PADDING(padding0_, sizeof(std::atomic<std::uint64_t>) + 2 * sizeof(std::uint32_t) + sizeof(std::uint64_t));
+
+            alignas(cache::kCacheLineSize) std::atomic<std::size_t> tail_{0};
+
+            PADDING(padding1_, sizeof(std::atomic<std::size_t>));
+
+            alignas(cache::kCacheLineSize) std::atomic<std::size_t> head_{0};
+
+            PADDING(padding2_, sizeof(std::atomic<std::size_t>));
+        };
+
+        static_assert(std::atomic<std::uint64_t>::is_always_lock_free && std::atomic<std::size_t>::is_always_lock_free,
+                      "The atomics in the shared memory must be lock free");
+
+    }
+
+    // Thrown on attach, when the shared memory object exists, but its creator has not initialized the queue yet.
+    // The attach can be retried
+    class SharedMemoryQueueNotReadyError final : public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    // Single producer single consumer queue for inter-process communication.
+    // The indices and the ring buffer are stored in the POSIX shared memory object, so the producer and the consumer
+    // can live in different processes. One process creates the queue, the other one attaches to it by name
+    template<typename T>
+    requires utils::IsTriviallyCopyable<T>
+    class SharedMemorySPSCQueue final {
+    private:
+        using Header = details::SharedMemorySPSCQueueHeader;
+
+    public:
+        // Creates the shared memory object with the given name. It is removed when the queue is destroyed
+        SharedMemorySPSCQueue(std::string name, std::size_t capacity);
+
+        // Attaches to the queue created by another process.
+        // The creator sizes and initializes the object after shm_open, so the attach, which comes in between, throws
+        // SharedMemoryQueueNotReadyError. The caller should retry it after a pause until its own deadline. If the object
+        // is not created yet, std::system_error with ENOENT is thrown, which can be retried the same way.
+        // Throws std::runtime_error if the layout of the queue is not compatible
+        explicit SharedMemorySPSCQueue(std::string name);
+
+        SharedMemorySPSCQueue(const SharedMemorySPSCQueue&) = delete;
+        SharedMemorySPSCQueue(SharedMemorySPSCQueue&&) = delete;
+        SharedMemorySPSCQueue& operator=(const SharedMemorySPSCQueue&) = delete;
+        SharedMemorySPSCQueue& operator=(SharedMemorySPSCQueue&&) = delete;
+
+        T* Front();
+
+        bool Enqueue(const T& element) noexcept;
+
+        bool Dequeue();
+        bool Dequeue(T& element);
+
+        [[nodiscard]] bool IsEmptyConsumer(); // IsEmpty method for consumer. It is faster than IsEmptyProducer()
+        [[nodiscard]] bool IsEmptyProducer() const noexcept; // IsEmpty method for producer
+        [[nodiscard]] std::size_t GetSize() const noexcept;
+        [[nodiscard]] std::size_t GetCapacity() const noexcept;
+
+        ~SharedMemorySPSCQueue();
+
+    private:
+        static constexpr std::size_t GetBufferOffset();
+
+        void Map(int fd, std::size_t mapping_size);
+
+        std::size_t GetIndexMask() const noexcept;
+
+    private:
+        PADDING(padding0_, 0);
+
+        Header* header_{nullptr};
+        T* buffer_{nullptr};
+        std::size_t buffer_size_{0};
+        std::size_t mapping_size_{0};
+        std::string name_;
+        bool is_owner_{false};
+
+        PADDING(padding1_, sizeof(Header*) + sizeof(T*) + 2 * sizeof(std::size_t) + sizeof(std::string) + sizeof(bool));
+
+        alignas(cache::kCacheLineSize) std::size_t cached_head_{0};
+
+        PADDING(padding2_, sizeof(std::size_t));
+
+        alignas(cache::kCacheLineSize) std::size_t cached_tail_{0};
+
+        PADDING(padding3_, sizeof(std::size_t));
+    };
+
+
+    // Implementation
+    template<typename T>
+    requires utils::IsTriviallyCopyable<T>
+    SharedMemorySPSCQueue<T>::SharedMemorySPSCQueue(std::string name, std::size_t capacity)
+            : buffer_size_(details::GetBufferSize(capacity)), name_(std::move(name)), is_owner_(true) {
+        const int fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+        if (fd == -1) {
+            throw std::system_error(errno, std::generic_category(), "Failed during shm_open");
+        }
+
+        const std::size_t mapping_size = GetBufferOffset() + buffer_size_ * sizeof(T);
+        if (ftruncate(fd, static_cast<off_t>(mapping_size)) == -1) {
+            const int error = errno;
+            close(fd);
+            shm_unlink(name_.c_str());
+            throw std::system_error(error, std::generic_category(), "Failed during ftruncate");
+        }
+
+        try {
+            Map(fd, mapping_size);
+        } catch (...) {
+            shm_unlink(name_.c_str());
+            throw;
+        }
+
+        header_ = new (header_) Header();
+        header_->version_ = details::kSharedMemoryQueueLayoutVersion;
+        header_->element_size_ = sizeof(T);
+        header_->buffer_size_ = buffer_size_;
+        header_->magic_.store(details::kSharedMemoryQueueMagic, std::memory_order_release);
+    }
+
+    template<typename T>
+    requires utils::IsTriviallyCopyable<T>
+    SharedMemorySPSCQueue<T>::SharedMemorySPSCQueue(std::string name) : name_(std::move(name)) {
+        const int fd = shm_open(name_.c_str(), O_RDWR, 0);
+        if (fd == -1) {
+            throw std::system_error(errno, std::generic_category(), "Failed during shm_open");
+        }
+
+        struct stat fd_stat{};
+        if (fstat(fd, &fd_stat) == -1) {
+            const int error = errno;
+            close(fd);
+            throw std::system_error(error, std::generic_category(), "Failed during fstat");
+        }
+        if (static_cast<std::size_t>(fd_stat.st_size) < GetBufferOffset()) {
+            close(fd);
+            throw SharedMemoryQueueNotReadyError("The shared memory object is not sized yet");
+        }
+
+        Map(fd, fd_stat.st_size);
+
+        const std::uint64_t magic = header_->magic_.load(std::memory_order_acquire);
+        if (!magic) {
+            munmap(header_, mapping_size_);
+            throw SharedMemoryQueueNotReadyError("The shared memory queue is not initialized yet");
+        }
+        if (magic != details::kSharedMemoryQueueMagic ||
+            header_->version_ != details::kSharedMemoryQueueLayoutVersion ||
+            header_->element_size_ != sizeof(T) ||
+            !std::has_single_bit(header_->buffer_size_) ||
+            GetBufferOffset() + header_->buffer_size_ * sizeof(T) > mapping_size_) {
+            munmap(header_, mapping_size_);
+            throw std::runtime_error("The layout of the shared memory queue is not compatible");
+        }
+
+        buffer_size_ = header_->buffer_size_;
+    }
+
+    template<typename T>
+    requires utils::IsTriviallyCopyable<T>
+    void SharedMemorySPSCQueue<T>::Map(int fd, std::size_t mapping_size) {
+        void* address = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        const int error = errno;
+        close(fd);
+
+        if (address == MAP_FAILED) {
+            throw std::system_error(error, std::generic_category(), "Failed during mmap");
+        }
+
+        mapping_size_ = mapping_size;
+        header_ = static_cast<Header*>(address);
+        buffer_ = reinterpret_cast<T*>(static_cast<std::byte*>(address) + GetBufferOffset());
+    }
+
+    template<typename T>
+    requires utils::IsTriviallyCopyable<T>
+    T* SharedMemorySPSCQueue<T>::Front() {
+        std::size_t head = header_->head_.load(std::memory_order_relaxed);
+
+        if (head == cached_tail_) {
+            cached_tail_ = header_->tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) {
+                return nullptr;
+            }
+        }
+        return &buffer_[head];
+    }
+
+    template<typename T>
+    requires utils::IsTriviallyCopyable<T>
+    bool SharedMemorySPSCQueue<T>::Enqueue(const T& element) noexcept {
+        const std::size_t tail = header_->tail_.load(std::memory_order_relaxed);
+        std::size_t next_tail = (tail + 1) & GetIndexMask();
+
+        if (next_tail == cached_head_) {
+            cached_head_ = header_->head_.load(std::memory_order_acquire);
+            if (next_tail == cached_head_) {
+                return false;
+            }
+        }
+
+        buffer_[tail] = element;
+        header_->tail_.store(next_tail, std::memory_order_release);
+
+        return true;
+    }
+
+    template<typename T>
+    requires utils::IsTriviallyCopyable<T>
+    bool SharedMemorySPSCQueue<T>::Dequeue() {
+        if (!Front()) {
+            return false;
+        }
+
+        const std::size_t head = header_->head_.load(std::memory_order_relaxed);
+        header_->head_.store((head + 1) & GetIndexMask(), std::memory_order_release);
+
+        return true;
+    }
+
+    template<typename T>
+    requires utils::IsTriviallyCopyable<T>
+    bool SharedMemorySPSCQueue<T>::Dequeue(T& element) {
+        T* front = Front();
+        if (!front) {
+            return false;
+        }
+
+        element = *front;
+
+        const std::size_t head = header_->head_.load(std::memory_order_relaxed);
+        header_->head_.store((head + 1) & GetIndexMask(), std::memory_order_release);
+
+        return true;
+    }
+
+    template<typename T>
+    requires utils::IsTriviallyCopyable<T>
+    bool SharedMemorySPSCQueue<T>::IsEmptyConsumer() {
+        return !Front();
+    }
+
+    template<typename T>
+    requires utils::IsTriviallyCopyable<T>
+    bool SharedMemorySPSCQueue<T>::IsEmptyProducer() const noexcept {
+        return header_->tail_.load(std::memory_order_acquire) == header_->head_.load(std::memory_order_acquire);
+    }
+
+    template<typename T>
+    requires utils::IsTriviallyCopyable<T>
+    std::size_t SharedMemorySPSCQueue<T>::GetSize() const noexcept {
+        return (header_->tail_.load(std::memory_order_acquire) - header_->head_.load(std::memory_order_acquire)) & GetIndexMask();
+    }
+
+    template<typename T>
+    requires utils::IsTriviallyCopyable<T>
+    std::size_t SharedMemorySPSCQueue<T>::GetCapacity() const noexcept {
+        return buffer_size_ - 1;
+    }
+
+    template<typename T>
+    requires utils::IsTriviallyCopyable<T>
+    SharedMemorySPSCQueue<T>::~SharedMemorySPSCQueue() {
+        munmap(header_, mapping_size_);
+        if (is_owner_) {
+            shm_unlink(name_.c_str());
+        }
+    }
+
+
+    template<typename T>
+    requires utils::IsTriviallyCopyable<T>
+    constexpr std::size_t SharedMemorySPSCQueue<T>::GetBufferOffset() {
+        constexpr std::size_t alignment = alignof(T) > cache::kCacheLineSize ? alignof(T) : cache::kCacheLineSize;
+        return (sizeof(Header) + alignment - 1) / alignment * alignment;
+    }
+
+    template<typename T>
+    requires utils::IsTriviallyCopyable<T>
+    std::size_t SharedMemorySPSCQueue<T>::GetIndexMask() const noexcept {
+        return buffer_size_ - 1;
+    }
+
+} // End of namespace concurrent::queue
+
+#endif //LOCK_FREE_SHARED_MEMORY_SP_SC_QUEUE_H
@@ -0,0 +1,253 @@
+#ifndef LOCK_FREE_UNBOUNDED_MP_MC_QUEUE_H
+#define LOCK_FREE_UNBOUNDED_MP_MC_QUEUE_H
+
+#include <atomic>
+#include <array>
+#include <utility>
+#include <type_traits>
+
+#include "cache_line.h"
+#include "wait.h"
+#include "hazard_pointer.h"
+#include "bounded_mp_mc_queue.h"
+
+namespace concurrent::queue {
+
+    inline constexpr std::size_t kDefaultSegmentCapacity = 1024;
+
+    namespace details {
+
+        // The segment is used once: the positions are not wrapped, so the generation of the slot is
+        // 0 (free), 1 (written) or 2 (read). The producers and the consumers, which get the position
+        // greater than Capacity, move to the next segment
+        template<typename T, std::size_t Capacity>
+        struct UnboundedMPMCQueueSegment {
+            alignas(cache::kCacheLineSize) std::atomic<std::size_t> head_{0};
+            alignas(cache::kCacheLineSize) std::atomic<std::size_t> tail_{0};
+            alignas(cache::kCacheLineSize) std::atomic<UnboundedMPMCQueueSegment*> next_{nullptr};
+
+            PADDING(padding0_, sizeof(std::atomic<UnboundedMPMCQueueSegment*>));
+
+            std::array<MPMCQueueSlot<T>, Capacity> slots_;
+        };
+
+    }
+
+    // The list of the BoundedMPMCQueue-like segments. Inside the segment the operations are the same as in
+    // BoundedMPMCQueue: one fetch_add and the generation of the slot. The producer, which gets the position
+    // after the end of the segment, appends the new segment. The drained segments are reclaimed
+    // with the hazard pointers, so Emplace and Dequeue protect the current segment before using it
+    template<typename T, std::size_t SegmentCapacity = kDefaultSegmentCapacity, typename WaitStrategy = wait::BusySpinWaitStrategy>
+    class UnboundedMPMCQueue {
+    public:
+        UnboundedMPMCQueue();
+
+        UnboundedMPMCQueue(const UnboundedMPMCQueue&) = delete;
+        UnboundedMPMCQueue(UnboundedMPMCQueue&&) = delete;
+        UnboundedMPMCQueue& operator=(const UnboundedMPMCQueue&) = delete;
+        UnboundedMPMCQueue& operator=(UnboundedMPMCQueue&&) = delete;
+
+        // Never waits. Allocates the new segment, when the current one is full
+        template<typename... Args, typename = std::enable_if_t<std::is_nothrow_constructible_v<T, Args...>, bool>>
+        void Emplace(Args&&... args);
+
+        template<typename = std::enable_if_t<std::is_nothrow_copy_constructible_v<T>, bool>>
+        void Enqueue(const T& element);
+
+        template<typename = std::enable_if_t<std::is_nothrow_move_constructible_v<T>, bool>>
+        void Enqueue(T&& element);
+
+        // Waits with the WaitStrategy for the element of its position
+        template<typename = std::enable_if_t<std::is_copy_constructible_v<T> || std::is_move_constructible_v<T>, bool>>
+        void Dequeue(T& element);
+
+        template<typename = std::enable_if_t<std::is_copy_constructible_v<T> || std::is_move_constructible_v<T>, bool>>
+        bool TryDequeue(T& element);
+
+        [[nodiscard]] bool IsEmpty() const noexcept;
+        [[nodiscard]] std::size_t GetSegmentCapacity() const noexcept;
+
+        ~UnboundedMPMCQueue();
+
+    private:
+        using Segment = details::UnboundedMPMCQueueSegment<T, SegmentCapacity>;
+
+        static constexpr Generation kWrittenGeneration = 1;
+        static constexpr Generation kReadGeneration = 2;
+
+        template<typename = std::enable_if_t<std::is_copy_constructible_v<T> || std::is_move_constructible_v<T>, bool>>
+        void Read(Segment* segment, std::size_t head, T& element);
+
+        // Links the next segment after the full one, if it is not linked yet, and moves the tail segment to it
+        void AppendSegment(Segment* segment);
+
+        // Moves the head segment from the drained one to the next. The thread, which moved it, retires the drained segment
+        void RemoveSegment(Segment* segment, Segment* next);
+
+    private:
+        static_assert(SegmentCapacity > 0, "The segment must have at least one slot");
+
+        alignas(cache::kCacheLineSize) std::atomic<Segment*> head_segment_;
+        alignas(cache::kCacheLineSize) std::atomic<Segment*> tail_segment_;
+
+        PADDING(padding0_, sizeof(std::atomic<Segment*>));
+
+        [[no_unique_address]] WaitStrategy wait_strategy_; // Consumers wait on it for the element of their position
+    };
+
+
+    // Implementation
+    template<typename T, std::size_t SegmentCapacity, typename WaitStrategy>
+    UnboundedMPMCQueue<T, SegmentCapacity, WaitStrategy>::UnboundedMPMCQueue() {
+        Segment* segment = new Segment();
+        head_segment_.store(segment, std::memory_order_relaxed);
+        tail_segment_.store(segment, std::memory_order_relaxed);
+    }
+
+    template<typename T, std::size_t SegmentCapacity, typename WaitStrategy>
+    template<typename... Args, typename>
+    void UnboundedMPMCQueue<T, SegmentCapacity, WaitStrategy>::Emplace(Args&&... args) {
+        reclamation::HazardPointer hazard_pointer;
+        while (true) {
+            Segment* segment = hazard_pointer.Protect(tail_segment_);
+
+            const std::size_t tail = segment->tail_.fetch_add(1);
+            if (tail < SegmentCapacity) {
+                segment->slots_[tail].Construct(std::forward<Args>(args)...);
+                segment->slots_[tail].StoreGeneration(kWrittenGeneration);
+                wait_strategy_.Notify();
+                return;
+            }
+
+            AppendSegment(segment);
+        }
+    }
+
+    template<typename T, std::size_t SegmentCapacity, typename WaitStrategy>
+    template<typename>
+    void UnboundedMPMCQueue<T, SegmentCapacity, WaitStrategy>::Enqueue(const T& element) {
+        Emplace(element);
+    }
+
+    template<typename T, std::size_t SegmentCapacity, typename WaitStrategy>
+    template<typename>
+    void UnboundedMPMCQueue<T, SegmentCapacity, WaitStrategy>::Enqueue(T&& element) {
+        Emplace(std::forward<T>(element));
+    }
+
+    template<typename T, std::size_t SegmentCapacity, typename WaitStrategy>
+    template<typename>
+    void UnboundedMPMCQueue<T, SegmentCapacity, WaitStrategy>::Dequeue(T& element) {
+        reclamation::HazardPointer hazard_pointer;
+        while (true) {
+            Segment* segment = hazard_pointer.Protect(head_segment_);
+
+            const std::size_t head = segment->head_.fetch_add(1);
+            if (head < SegmentCapacity) {
+                wait_strategy_.Wait([&] { return kWrittenGeneration == segment->slots_[head].LoadGeneration(); });
+                Read(segment, head, element);
+                return;
+            }
+
+            // The segment is drained, the next one is appended by the producer, which gets the position after the end
+            Segment* next = nullptr;
+            wait_strategy_.Wait([&] { return (next = segment->next_.load(std::memory_order_acquire)) != nullptr; });
+            RemoveSegment(segment, next);
+        }
+    }
+
+    template<typename T, std::size_t SegmentCapacity, typename WaitStrategy>
+    template<typename>
+    bool UnboundedMPMCQueue<T, SegmentCapacity, WaitStrategy>::TryDequeue(T& element) {
+        reclamation::HazardPointer hazard_pointer;
+        while (true) {
+            Segment* segment = hazard_pointer.Protect(head_segment_);
+
+            std::size_t head = segment->head_.load(std::memory_order_acquire);
+            while (head < SegmentCapacity) {
+                if (kWrittenGeneration == segment->slots_[head].LoadGeneration()) {
+                    if (segment->head_.compare_exchange_weak(head, head + 1)) {
+                        Read(segment, head, element);
+                        return true;
+                    }
+                } else {
+                    const std::size_t new_head = segment->head_.load(std::memory_order_acquire);
+                    if (head == new_head) {
+                        return false;
+                    }
+                    head = new_head;
+                }
+            }
+
+            Segment* next = segment->next_.load(std::memory_order_acquire);
+            if (!next) {
+                return false;
+            }
+            RemoveSegment(segment, next);
+        }
+    }
+
+    template<typename T, std::size_t SegmentCapacity, typename WaitStrategy>
+    bool UnboundedMPMCQueue<T, SegmentCapacity, WaitStrategy>::IsEmpty() const noexcept {
+        reclamation::HazardPointer hazard_pointer;
+        Segment* segment = hazard_pointer.Protect(head_segment_);
+
+        const std::size_t head = segment->head_.load(std::memory_order_acquire);
+        if (head < SegmentCapacity) {
+            return head >= segment->tail_.load(std::memory_order_acquire);
+        }
+        return !segment->next_.load(std::memory_order_acquire);
+    }
+
+    template<typename T, std::size_t SegmentCapacity, typename WaitStrategy>
+    std::size_t UnboundedMPMCQueue<T, SegmentCapacity, WaitStrategy>::GetSegmentCapacity() const noexcept {
+        return SegmentCapacity;
+    }
+
+    template<typename T, std::size_t SegmentCapacity, typename WaitStrategy>
+    UnboundedMPMCQueue<T, SegmentCapacity, WaitStrategy>::~UnboundedMPMCQueue() {
+        Segment* segment = head_segment_.load(std::memory_order_acquire);
+        while (segment) {
+            Segment* next = segment->next_.load(std::memory_order_acquire);
+            delete segment; // The slots destroy the elements, which were not read
+            segment = next;
+        }
+    }
+
+
+    template<typename T, std::size_t SegmentCapacity, typename WaitStrategy>
+    template<typename>
+    void UnboundedMPMCQueue<T, SegmentCapacity, WaitStrategy>::Read(Segment* segment, std::size_t head, T& element) {
+        element = segment->slots_[head].Move();
+        segment->slots_[head].Destroy();
+        segment->slots_[head].StoreGeneration(kReadGeneration);
+    }
+
+    template<typename T, std::size_t SegmentCapacity, typename WaitStrategy>
+    void UnboundedMPMCQueue<T, SegmentCapacity, WaitStrategy>::AppendSegment(Segment* segment) {
+        Segment* next = segment->next_.load(std::memory_order_acquire);
+        if (!next) {
+            Segment* new_segment = new Segment();
+            if (segment->next_.compare_exchange_strong(next, new_segment)) {
+                next = new_segment;
+                wait_strategy_.Notify();
+            } else {
+                delete new_segment;
+            }
+        }
+        tail_segment_.compare_exchange_strong(segment, next);
+    }
+
+    template<typename T, std::size_t SegmentCapacity, typename WaitStrategy>
+    void UnboundedMPMCQueue<T, SegmentCapacity, WaitStrategy>::RemoveSegment(Segment* segment, Segment* next) {
+        // The tail segment is moved first, so the retired segment is not reachable from both ends
+        Segment* expected = segment;
+        tail_segment_.compare_exchange_strong(expected, next);
+        if (head_segment_.compare_exchange_strong(segment, next)) {
+            reclamation::Retire(segment);
+        }
+    }
+
+} // End of namespace concurrent::queue
+
+#endif //LOCK_FREE_UNBOUNDED_MP_MC_QUEUE_H
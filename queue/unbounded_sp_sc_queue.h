@@ -0,0 +1,235 @@
+#ifndef LOCK_FREE_UNBOUNDED_SP_SC_QUEUE_H
+#define LOCK_FREE_UNBOUNDED_SP_SC_QUEUE_H
+
+#include <memory>
+#include <atomic>
+#include <type_traits>
+#include <utility>
+#include <cstddef>
+
+#include "cache_line.h"
+#include "bounded_sp_sc_queue.h"
+
+namespace concurrent::queue {
+
+    namespace details {
+
+        inline constexpr std::size_t kDefaultSegmentCapacity = 1024;
+        inline constexpr std::size_t kSegmentsFreeListCapacity = 8;
+
+        // Ring segment of the unbounded queue. The producer links the next segment when the ring is full
+        template<typename T, std::size_t Capacity, typename Allocator>
+        struct UnboundedSPSCQueueSegment {
+            explicit UnboundedSPSCQueueSegment(const Allocator& allocator) : queue_(allocator) {}
+
+            BoundedSPSCQueue<T, Capacity, Allocator> queue_;
+
+            alignas(cache::kCacheLineSize) std::atomic<UnboundedSPSCQueueSegment*> next_{nullptr};
+
+            PADDING(padding_, sizeof(std::atomic<UnboundedSPSCQueueSegment*>));
+        };
+
+    }
+
+    // Single producer single consumer queue without the capacity limit.
+    // It is a list of BoundedSPSCQueue segments. The drained segments are returned to the producer through
+    // the small free list, so the queue does not allocate memory in the steady state
+    template<typename T, std::size_t SegmentCapacity = details::kDefaultSegmentCapacity, typename Allocator = std::allocator<T>>
+    class UnboundedSPSCQueue final {
+    public:
+        UnboundedSPSCQueue();
+        explicit UnboundedSPSCQueue(const Allocator& allocator);
+
+        UnboundedSPSCQueue(const UnboundedSPSCQueue&) = delete;
+        UnboundedSPSCQueue(UnboundedSPSCQueue&&) = delete;
+        UnboundedSPSCQueue& operator=(const UnboundedSPSCQueue&) = delete;
+        UnboundedSPSCQueue& operator=(UnboundedSPSCQueue&&) = delete;
+
+        T* Front();
+
+        template<typename... Args>
+        void Emplace(Args&&... args);
+
+        template<typename = std::enable_if_t<std::is_copy_constructible_v<T>, bool>>
+        void Enqueue(const T& element);
+
+        template<typename = std::enable_if_t<std::is_move_constructible_v<T>, bool>>
+        void Enqueue(T&& element);
+
+        bool Dequeue();
+
+        template<typename = std::enable_if_t<std::is_copy_constructible_v<T> || std::is_move_constructible_v<T>, bool>>
+        bool Dequeue(T& element);
+
+        [[nodiscard]] bool IsEmptyConsumer(); // IsEmpty method for consumer
+
+        ~UnboundedSPSCQueue();
+
+    private:
+        using Segment = details::UnboundedSPSCQueueSegment<T, SegmentCapacity, Allocator>;
+        using SegmentAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Segment>;
+        using SegmentAllocatorTraits = std::allocator_traits<SegmentAllocator>;
+        using FreeList = BoundedSPSCQueue<Segment*, details::kSegmentsFreeListCapacity>;
+
+        Segment* CreateSegment();
+        void DestroySegment(Segment* segment);
+
+        // Links the new segment to the tail of the list. Called by producer, when the tail segment is full
+        Segment* LinkSegment();
+
+        // Moves the head to the next segment, if the head segment is drained. Called by consumer, when it is empty
+        bool MoveHeadSegment();
+
+    private:
+        PADDING(padding0_, 0);
+
+        [[no_unique_address]] Allocator allocator_;
+        [[no_unique_address]] SegmentAllocator segment_allocator_;
+
+        FreeList free_segments_; // The consumer returns the drained segments, the producer reuses them
+
+        alignas(cache::kCacheLineSize) Segment* tail_segment_{nullptr};
+
+        PADDING(padding1_, sizeof(Segment*));
+
+        alignas(cache::kCacheLineSize) Segment* head_segment_{nullptr};
+
+        PADDING(padding2_, sizeof(Segment*));
+    };
+
+
+    // Implementation
+    template<typename T, std::size_t SegmentCapacity, typename Allocator>
+    UnboundedSPSCQueue<T, SegmentCapacity, Allocator>::UnboundedSPSCQueue() : UnboundedSPSCQueue(Allocator()) {}
+
+    template<typename T, std::size_t SegmentCapacity, typename Allocator>
+    UnboundedSPSCQueue<T, SegmentCapacity, Allocator>::UnboundedSPSCQueue(const Allocator& allocator)
+            : allocator_(allocator), segment_allocator_(allocator) {
+        head_segment_ = tail_segment_ = CreateSegment();
+    }
+
+    template<typename T, std::size_t SegmentCapacity, typename Allocator>
+    T* UnboundedSPSCQueue<T, SegmentCapacity, Allocator>::Front() {
+        T* front = head_segment_->queue_.Front();
+        while (!front && MoveHeadSegment()) {
+            front = head_segment_->queue_.Front();
+        }
+        return front;
+    }
+
+    template<typename T, std::size_t SegmentCapacity, typename Allocator>
+    template<typename... Args>
+    void UnboundedSPSCQueue<T, SegmentCapacity, Allocator>::Emplace(Args&&... args) {
+        // Emplace uses the arguments only if it succeeds, so they can be forwarded to the new segment
+        if (!tail_segment_->queue_.Emplace(std::forward<Args>(args)...)) {
+            LinkSegment()->queue_.Emplace(std::forward<Args>(args)...);
+        }
+    }
+
+    template<typename T, std::size_t SegmentCapacity, typename Allocator>
+    template<typename>
+    void UnboundedSPSCQueue<T, SegmentCapacity, Allocator>::Enqueue(const T& element) {
+        Emplace(element);
+    }
+
+    template<typename T, std::size_t SegmentCapacity, typename Allocator>
+    template<typename>
+    void UnboundedSPSCQueue<T, SegmentCapacity, Allocator>::Enqueue(T&& element) {
+        Emplace(std::forward<T>(element));
+    }
+
+    template<typename T, std::size_t SegmentCapacity, typename Allocator>
+    bool UnboundedSPSCQueue<T, SegmentCapacity, Allocator>::Dequeue() {
+        if (!Front()) {
+            return false;
+        }
+        return head_segment_->queue_.Dequeue();
+    }
+
+    template<typename T, std::size_t SegmentCapacity, typename Allocator>
+    template<typename>
+    bool UnboundedSPSCQueue<T, SegmentCapacity, Allocator>::Dequeue(T& element) {
+        if (!Front()) {
+            return false;
+        }
+        return head_segment_->queue_.Dequeue(element);
+    }
+
+    template<typename T, std::size_t SegmentCapacity, typename Allocator>
+    bool UnboundedSPSCQueue<T, SegmentCapacity, Allocator>::IsEmptyConsumer() {
+        return !Front();
+    }
+
+    template<typename T, std::size_t SegmentCapacity, typename Allocator>
+    UnboundedSPSCQueue<T, SegmentCapacity, Allocator>::~UnboundedSPSCQueue() {
+        while (head_segment_) {
+            Segment* next = head_segment_->next_.load(std::memory_order_relaxed);
+            DestroySegment(head_segment_);
+            head_segment_ = next;
+        }
+
+        Segment* segment = nullptr;
+        while (free_segments_.Dequeue(segment)) {
+            DestroySegment(segment);
+        }
+    }
+
+
+    template<typename T, std::size_t SegmentCapacity, typename Allocator>
+    typename UnboundedSPSCQueue<T, SegmentCapacity, Allocator>::Segment* UnboundedSPSCQueue<T, SegmentCapacity, Allocator>::CreateSegment() {
+        Segment* segment = SegmentAllocatorTraits::allocate(segment_allocator_, 1);
+        try {
+            SegmentAllocatorTraits::construct(segment_allocator_, segment, allocator_);
+        } catch (...) {
+            SegmentAllocatorTraits::deallocate(segment_allocator_, segment, 1);
+            throw;
+        }
+        return segment;
+    }
+
+    template<typename T, std::size_t SegmentCapacity, typename Allocator>
+    void UnboundedSPSCQueue<T, SegmentCapacity, Allocator>::DestroySegment(Segment* segment) {
+        SegmentAllocatorTraits::destroy(segment_allocator_, segment);
+        SegmentAllocatorTraits::deallocate(segment_allocator_, segment, 1);
+    }
+
+    template<typename T, std::size_t SegmentCapacity, typename Allocator>
+    typename UnboundedSPSCQueue<T, SegmentCapacity, Allocator>::Segment* UnboundedSPSCQueue<T, SegmentCapacity, Allocator>::LinkSegment() {
+        Segment* segment = nullptr;
+        if (!free_segments_.Dequeue(segment)) {
+            segment = CreateSegment();
+        }
+
+        // The producer never writes to the old segment after the new one is linked
+        tail_segment_->next_.store(segment, std::memory_order_release);
+        tail_segment_ = segment;
+
+        return segment;
+    }
+
+    template<typename T, std::size_t SegmentCapacity, typename Allocator>
+    bool UnboundedSPSCQueue<T, SegmentCapacity, Allocator>::MoveHeadSegment() {
+        Segment* next = head_segment_->next_.load(std::memory_order_acquire);
+        if (!next) {
+            return false;
+        }
+
+        // The elements written before the next segment was linked are visible now
+        if (!head_segment_->queue_.IsEmptyConsumer()) {
+            return true;
+        }
+
+        Segment* drained = head_segment_;
+        head_segment_ = next;
+
+        drained->next_.store(nullptr, std::memory_order_relaxed);
+        if (!free_segments_.Enqueue(drained)) {
+            DestroySegment(drained);
+        }
+
+        return true;
+    }
+
+} // End of namespace concurrent::queue
+
+#endif //LOCK_FREE_UNBOUNDED_SP_SC_QUEUE_H
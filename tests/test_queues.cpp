@@ -1 +1,366 @@
+#undef NDEBUG // The checks must work in the release build too
+#include <cassert>
+#include <thread>
+#include <vector>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <atomic>
+#include <cstdlib>
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
 
+#include "bounded_mp_mc_queue.h"
+#include "bounded_sp_sc_queue.h"
+#include "batched_bounded_sp_sc_queue.h"
+#include "bounded_sp_sc_byte_queue.h"
+#include "shared_memory_sp_sc_queue.h"
+#include "sharded_mp_mc_queue.h"
+#include "unbounded_mp_mc_queue.h"
+#include "hazard_pointer.h"
+
+namespace concurrent::test::queue {
+
+    // The token holds the claimed slots, which the producers wait for. The producers finish after the token is drained
+    void TestConsumerTokenDrain() {
+        using Queue = concurrent::queue::BoundedMPMCQueue<int, 4>;
+        Queue q;
+
+        const auto capacity = static_cast<int>(q.GetCapacity());
+        for (int i = 0; i < capacity; ++i) {
+            q.Enqueue(i);
+        }
+
+        std::vector<int> drained;
+        {
+            Queue::ConsumerToken token{&q, q.GetCapacity()};
+
+            int element = -1;
+            assert(token.TryDequeue(element) && element == 0);
+
+            std::vector<std::thread> producers;
+            for (int i = 0; i < 2; ++i) {
+                producers.emplace_back([&q, capacity, i] { q.Enqueue(capacity + i); });
+            }
+
+            assert(token.Drain(std::back_inserter(drained)) == static_cast<std::size_t>(capacity - 1));
+            assert(token.IsDrained());
+
+            for (auto& producer : producers) {
+                producer.join();
+            }
+        }
+
+        for (int i = 1; i < capacity; ++i) {
+            assert(drained[i - 1] == i);
+        }
+
+        int first = -1;
+        int second = -1;
+        assert(q.TryDequeue(first) && q.TryDequeue(second));
+        assert(first + second == 2 * capacity + 1);
+        assert(q.IsEmpty());
+
+        // The token, which is destroyed with the claimed elements, terminates the process in every build
+        const pid_t pid = fork();
+        assert(pid != -1);
+        if (!pid) {
+            for (int i = 0; i < capacity; ++i) {
+                q.Enqueue(i);
+            }
+            {
+                Queue::ConsumerToken token{&q, q.GetCapacity()};
+                int element = -1;
+                static_cast<void>(token.TryDequeue(element));
+            }
+            std::_Exit(EXIT_SUCCESS);
+        }
+
+        int status = 0;
+        assert(waitpid(pid, &status, 0) == pid);
+        assert(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT);
+    }
+
+    // The bulk claim of only the skipped positions (after ProducerToken::Flush) must go on to the written elements
+    void TestDequeueBulkAfterSkipped() {
+        using Queue = concurrent::queue::BoundedMPMCQueue<int, 8>;
+        Queue q;
+        {
+            Queue::ProducerToken token{&q, 4};
+            token.Enqueue(1);
+            token.Flush(); // Skips the positions 1-3
+        }
+        q.Enqueue(2);
+
+        int element = 0;
+        assert(q.TryDequeue(element) && element == 1);
+
+        std::vector<int> elements;
+        assert(q.TryDequeueBulk(std::back_inserter(elements), 3) == 1);
+        assert(elements.size() == 1 && elements[0] == 2);
+        assert(q.TryDequeueBulk(std::back_inserter(elements), 3) == 0 && q.IsEmpty());
+    }
+
+    // The home shards are given per queue, and the producer and the consumer of one token shard meet in it
+    void TestShardedHomeShards() {
+        using Queue = concurrent::queue::ShardedMPMCQueue<int>;
+        Queue first{1024, 4}; // The elements of the producer fit in its shard, so they stay in order
+        Queue second{4, 4};
+
+        // The first thread of every queue gets its first shard, whatever it did with the other queues
+        first.Enqueue(1);
+        second.Enqueue(2);
+        Queue::Token first_consumer{&first, 0};
+        Queue::Token second_consumer{&second, 0};
+        int element = 0;
+        assert(first_consumer.TryDequeue(element) && element == 1);
+        assert(second_consumer.TryDequeue(element) && element == 2);
+
+        std::thread producer([&first] {
+            Queue::Token token{&first, 2};
+            for (int i = 0; i < 1000; ++i) {
+                token.Enqueue(i);
+            }
+        });
+        Queue::Token consumer{&first, 2};
+        for (int i = 0; i < 1000; ++i) {
+            consumer.Dequeue(element);
+            assert(element == i);
+        }
+        producer.join();
+        assert(first.IsEmpty());
+
+        Queue::Token round_robin{&second};
+        assert(round_robin.GetHomeShard() == 1);
+    }
+
+    // The retired nodes may outlive the test until the thread exit, so the flags are static
+    struct ReclaimedNode {
+        static inline bool is_first_reclaimed = false;
+        static inline bool is_second_reclaimed = false;
+
+        bool* is_reclaimed{nullptr};
+
+        ~ReclaimedNode() {
+            if (is_reclaimed) {
+                *is_reclaimed = true;
+            }
+        }
+    };
+
+    // The nested hazard pointers of one thread protect their nodes independently
+    void TestNestedHazardPointers() {
+        using concurrent::reclamation::HazardPointer;
+        using concurrent::reclamation::Retire;
+        using concurrent::reclamation::kRetiredScanThreshold;
+
+        std::atomic<ReclaimedNode*> first{new ReclaimedNode{&ReclaimedNode::is_first_reclaimed}};
+        std::atomic<ReclaimedNode*> second{new ReclaimedNode{&ReclaimedNode::is_second_reclaimed}};
+
+        HazardPointer outer;
+        ReclaimedNode* protected_node = outer.Protect(first);
+        {
+            HazardPointer inner;
+            assert(inner.Protect(second) == second.load());
+        } // Must not clear the protection of outer
+
+        Retire(protected_node);
+        Retire(second.load());
+        for (std::size_t i = 0; i < kRetiredScanThreshold; ++i) {
+            Retire(new ReclaimedNode{});
+        }
+        assert(!ReclaimedNode::is_first_reclaimed && ReclaimedNode::is_second_reclaimed);
+
+        outer.Reset();
+        for (std::size_t i = 0; i < kRetiredScanThreshold; ++i) {
+            Retire(new ReclaimedNode{});
+        }
+        assert(ReclaimedNode::is_first_reclaimed);
+    }
+
+    // Many producers and consumers pass the elements through the small segments, so the segments are appended
+    // and reclaimed all the time. Every element is dequeued exactly once
+    void TestUnboundedMPMCQueueSum() {
+        concurrent::queue::UnboundedMPMCQueue<std::size_t, 4> q;
+
+        const std::size_t threads_count = 4;
+        const std::size_t count = 20000;
+
+        std::vector<std::thread> threads;
+        std::atomic<std::size_t> sum{0};
+        for (std::size_t t = 0; t < threads_count; ++t) {
+            threads.emplace_back([&q, t] {
+                for (std::size_t i = 0; i < count; ++i) {
+                    q.Enqueue(t * count + i + 1);
+                }
+            });
+            threads.emplace_back([&q, &sum] {
+                std::size_t local_sum = 0;
+                std::size_t element = 0;
+                for (std::size_t i = 0; i < count; ++i) {
+                    q.Dequeue(element);
+                    local_sum += element;
+                }
+                sum.fetch_add(local_sum, std::memory_order_relaxed);
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        const std::size_t total_count = threads_count * count;
+        assert(sum.load() == total_count * (total_count + 1) / 2);
+        std::size_t element = 0;
+        assert(q.IsEmpty() && !q.TryDequeue(element));
+    }
+
+    // Release on the empty queue must not move the head past the tail, where the producer writes the next batch
+    void TestBatchedReleaseEmpty() {
+        concurrent::queue::BatchedBoundedSPSCQueue<int, 16> q;
+
+        assert(q.Peek().empty());
+        q.Release(0);
+        q.Release(1);
+        assert(q.IsEmptyConsumer());
+
+        q.Enqueue(1);
+        q.Enqueue(2);
+        q.Flush();
+
+        q.Release(0);
+        const auto batch = q.Peek();
+        assert(batch.size() == 2 && batch[0] == 1 && batch[1] == 2);
+        q.Release(batch.size());
+        assert(q.Peek().empty());
+        q.Release(1);
+        assert(q.IsEmptyConsumer());
+
+        q.Enqueue(3);
+        q.Flush();
+        assert(q.Front() && *q.Front() == 3);
+        assert(q.Dequeue() && q.IsEmptyConsumer());
+    }
+
+    // GetCapacity is the number of elements, which the producer can enqueue before the consumer dequeues any
+    template<typename Queue>
+    void CheckSPSCCapacity(Queue& q) {
+        std::size_t count = 0;
+        while (q.Enqueue(static_cast<int>(count))) {
+            ++count;
+        }
+        assert(count == q.GetCapacity() && q.GetSize() == q.GetCapacity());
+    }
+
+    void TestSPSCCapacity() {
+        concurrent::queue::BoundedSPSCQueue<int, 16> static_queue;
+        CheckSPSCCapacity(static_queue);
+
+        concurrent::queue::BoundedSPSCQueue<int> dynamic_queue{16};
+        CheckSPSCCapacity(dynamic_queue);
+    }
+
+    // GetCapacity is the number of elements, which the producer can enqueue before the consumer releases any
+    void TestBatchedCapacity() {
+        concurrent::queue::BatchedBoundedSPSCQueue<int, 16> q;
+
+        std::size_t count = 0;
+        while (q.Enqueue(static_cast<int>(count))) {
+            ++count;
+        }
+        assert(count == q.GetCapacity());
+    }
+
+    // The small dynamic capacity is rounded up, so the queue still takes a message of one block
+    void TestByteQueueMinCapacity() {
+        concurrent::queue::BoundedSPSCByteQueue<> q{1};
+        assert(q.GetMaxMessageSize() > 0 && q.GetMaxMessageSize() < q.GetCapacity());
+    }
+
+    // The attach between the shm_open and the initialization of the creator must be reported as retryable
+    void TestSharedMemoryAttachNotReady() {
+        using Queue = concurrent::queue::SharedMemorySPSCQueue<int>;
+        const std::string name = "/concurrent_test_attach_" + std::to_string(getpid());
+
+        const auto is_not_ready = [&name] {
+            try {
+                Queue q{name};
+            } catch (const concurrent::queue::SharedMemoryQueueNotReadyError&) {
+                return true;
+            } catch (...) {
+            }
+            return false;
+        };
+
+        const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+        assert(fd != -1);
+        assert(is_not_ready()); // Before ftruncate
+        assert(ftruncate(fd, 1 << 16) == 0);
+        assert(is_not_ready()); // Before the magic is stored
+        close(fd);
+        shm_unlink(name.c_str());
+
+        Queue creator{name, 16};
+        Queue attached{name};
+        assert(creator.Enqueue(1));
+        int element = 0;
+        assert(attached.Dequeue(element) && element == 1);
+
+        std::size_t count = 0;
+        while (creator.Enqueue(static_cast<int>(count))) {
+            ++count;
+        }
+        assert(count == creator.GetCapacity() && attached.GetCapacity() == creator.GetCapacity());
+    }
+
+    // The size of the ring from the header, which is not a power of two, would give the wrong index mask
+    void TestSharedMemoryAttachCorruptHeader() {
+        using Queue = concurrent::queue::SharedMemorySPSCQueue<int>;
+        using Header = concurrent::queue::details::SharedMemorySPSCQueueHeader;
+        const std::string name = "/concurrent_test_corrupt_" + std::to_string(getpid());
+
+        const std::size_t size = 1 << 16;
+        const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+        assert(fd != -1 && ftruncate(fd, size) == 0);
+        void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        assert(address != MAP_FAILED);
+        close(fd);
+
+        auto* header = new (address) Header();
+        header->version_ = concurrent::queue::details::kSharedMemoryQueueLayoutVersion;
+        header->element_size_ = sizeof(int);
+        header->buffer_size_ = 3;
+        header->magic_.store(concurrent::queue::details::kSharedMemoryQueueMagic, std::memory_order_release);
+
+        bool is_rejected = false;
+        try {
+            Queue q{name};
+        } catch (const concurrent::queue::SharedMemoryQueueNotReadyError&) {
+        } catch (const std::runtime_error&) {
+            is_rejected = true;
+        }
+        assert(is_rejected);
+
+        munmap(address, size);
+        shm_unlink(name.c_str());
+    }
+
+} // End of namespace concurrent::test::queue
+
+int main() {
+    concurrent::test::queue::TestConsumerTokenDrain();
+    concurrent::test::queue::TestDequeueBulkAfterSkipped();
+    concurrent::test::queue::TestShardedHomeShards();
+    concurrent::test::queue::TestNestedHazardPointers();
+    concurrent::test::queue::TestUnboundedMPMCQueueSum();
+    concurrent::test::queue::TestBatchedReleaseEmpty();
+    concurrent::test::queue::TestBatchedCapacity();
+    concurrent::test::queue::TestSPSCCapacity();
+    concurrent::test::queue::TestByteQueueMinCapacity();
+    concurrent::test::queue::TestSharedMemoryAttachNotReady();
+    concurrent::test::queue::TestSharedMemoryAttachCorruptHeader();
+    return 0;
+}
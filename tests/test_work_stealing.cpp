@@ -0,0 +1,135 @@
+#undef NDEBUG // The checks must work in the release build too
+#include <cassert>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "work_stealing_deque.h"
+#include "work_stealing_executor.h"
+
+namespace concurrent::test::work_stealing {
+
+    // The owner pushes past the capacity, so the array grows while the elements are in it, and pops them in LIFO order
+    void TestDequeGrow() {
+        deque::WorkStealingDeque<std::size_t> d{2};
+        const std::size_t count = 100;
+        for (std::size_t i = 0; i < count; ++i) {
+            d.Push(i);
+        }
+        assert(d.GetSize() == count && d.GetCapacity() >= count);
+
+        std::size_t stolen = count;
+        assert(d.Steal(stolen) && stolen == 0);
+
+        for (std::size_t i = count - 1; i > 0; --i) {
+            std::size_t element = 0;
+            assert(d.Pop(element) && element == i);
+        }
+        std::size_t element = 0;
+        assert(!d.Pop(element) && !d.Steal(element) && d.IsEmpty());
+    }
+
+    // The owner and the thieves race for the last element again and again. Every element is taken exactly once
+    void TestDequeLastElementRace() {
+        deque::WorkStealingDeque<std::uint32_t> d{4};
+        const std::uint32_t count = 100000;
+        const std::size_t thieves_count = 3;
+
+        std::vector<std::atomic<std::uint32_t>> taken(count);
+        std::atomic<bool> is_done{false};
+
+        std::vector<std::thread> thieves;
+        for (std::size_t i = 0; i < thieves_count; ++i) {
+            thieves.emplace_back([&] {
+                std::uint32_t element = 0;
+                while (!is_done.load(std::memory_order_acquire)) {
+                    if (d.Steal(element)) {
+                        taken[element].fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+            });
+        }
+
+        for (std::uint32_t i = 0; i < count; ++i) {
+            d.Push(i);
+            if (i % 2) {
+                std::uint32_t element = 0;
+                if (d.Pop(element)) {
+                    taken[element].fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+        std::uint32_t element = 0;
+        while (!d.IsEmpty()) {
+            if (d.Pop(element)) {
+                taken[element].fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        is_done.store(true, std::memory_order_release);
+        for (auto& thief : thieves) {
+            thief.join();
+        }
+
+        for (const auto& counter : taken) {
+            assert(counter.load(std::memory_order_relaxed) == 1);
+        }
+    }
+
+    std::uint64_t Fib(executor::WorkStealingExecutor<>& executor, int n) {
+        if (n < 2) {
+            return n;
+        }
+
+        std::atomic<bool> is_done{false};
+        std::uint64_t left = 0;
+        executor.Submit([&] {
+            left = Fib(executor, n - 1);
+            is_done.store(true, std::memory_order_release);
+        });
+        const std::uint64_t right = Fib(executor, n - 2);
+        executor.RunUntil([&] { return is_done.load(std::memory_order_acquire); });
+        return left + right;
+    }
+
+    // The fork-join tasks are submitted by the workers to their own deques and stolen by the others
+    void TestExecutorForkJoin() {
+        executor::WorkStealingExecutor<> executor{4};
+
+        std::atomic<bool> is_done{false};
+        std::uint64_t result = 0;
+        executor.Submit([&] {
+            result = Fib(executor, 20);
+            is_done.store(true, std::memory_order_release);
+        });
+        executor.RunUntil([&] { return is_done.load(std::memory_order_acquire); });
+        assert(result == 6765);
+    }
+
+    // The destructor runs the tasks, which are submitted before it, including the tasks submitted by these tasks
+    void TestExecutorShutdownDrain() {
+        const std::size_t count = 10000;
+        std::atomic<std::size_t> run_count{0};
+        {
+            executor::WorkStealingExecutor<> executor{2};
+            for (std::size_t i = 0; i < count; ++i) {
+                executor.Submit([&executor, &run_count] {
+                    run_count.fetch_add(1, std::memory_order_relaxed);
+                    executor.Submit([&run_count] { run_count.fetch_add(1, std::memory_order_relaxed); });
+                });
+            }
+        }
+        assert(run_count.load(std::memory_order_relaxed) == 2 * count);
+    }
+
+} // End of namespace concurrent::test::work_stealing
+
+int main() {
+    concurrent::test::work_stealing::TestDequeGrow();
+    concurrent::test::work_stealing::TestDequeLastElementRace();
+    concurrent::test::work_stealing::TestExecutorForkJoin();
+    concurrent::test::work_stealing::TestExecutorShutdownDrain();
+    return 0;
+}
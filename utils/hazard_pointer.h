@@ -0,0 +1,249 @@
+#ifndef LOCK_FREE_DATA_STRUCTURES_HAZARD_POINTER_H
+#define LOCK_FREE_DATA_STRUCTURES_HAZARD_POINTER_H
+
+#include <atomic>
+#include <array>
+#include <vector>
+#include <mutex>
+#include <algorithm>
+#include <stdexcept>
+#include <cstddef>
+
+#include "cache_line.h"
+
+namespace concurrent::reclamation {
+
+    // The maximum number of the hazard records. Every live HazardPointer holds one, and every thread keeps
+    // the records of its destroyed HazardPointers for reuse until it exits
+    inline constexpr std::size_t kMaxHazardPointersCount = 256;
+
+    // The thread scans the hazard pointers, when it has retired this number of nodes
+    inline constexpr std::size_t kRetiredScanThreshold = 16;
+
+    namespace details {
+
+        struct HazardRecord {
+            alignas(cache::kCacheLineSize) std::atomic<void*> pointer_{nullptr};
+            std::atomic<bool> is_owned_{false};
+            HazardRecord* next_free_{nullptr}; // The next free record of the owner thread. Used only by the owner
+
+            PADDING(padding_, sizeof(std::atomic<void*>) + sizeof(std::atomic<bool>) + sizeof(HazardRecord*));
+        };
+
+        struct RetiredNode {
+            void* pointer_;
+            void (*deleter_)(void*);
+        };
+
+        // The records of all threads and the nodes left by the finished threads
+        class HazardDomain {
+        public:
+            HazardRecord* AcquireRecord();
+            void ReleaseRecord(HazardRecord* record) noexcept;
+
+            // Deletes the retired nodes, which are not protected by any record. The protected nodes stay in retired
+            void Reclaim(std::vector<RetiredNode>& retired);
+
+            void AddOrphans(std::vector<RetiredNode>& retired);
+
+            ~HazardDomain();
+
+        private:
+            std::array<HazardRecord, kMaxHazardPointersCount> records_{};
+
+            std::mutex orphans_mutex_;
+            std::vector<RetiredNode> orphans_;
+        };
+
+        HazardDomain& GetHazardDomain();
+
+        // The free records and the retired nodes of the current thread. The records are acquired from the domain,
+        // when the thread has no free one, and released on the thread exit, the nodes, which are still protected,
+        // are passed to the domain
+        class ThreadContext {
+        public:
+            HazardRecord* AcquireRecord();
+            void ReleaseRecord(HazardRecord* record) noexcept;
+
+            void Retire(RetiredNode node);
+
+            ~ThreadContext();
+
+        private:
+            HazardRecord* free_records_{nullptr};
+            std::vector<RetiredNode> retired_;
+        };
+
+        ThreadContext& GetThreadContext();
+
+    }
+
+    // Protects one node from the reclamation. Every HazardPointer has its own record, so the thread can protect
+    // several nodes at a time (for example, in the nested calls). The record is returned to the thread in the destructor
+    class HazardPointer {
+    public:
+        HazardPointer();
+
+        HazardPointer(const HazardPointer&) = delete;
+        HazardPointer(HazardPointer&&) = delete;
+        HazardPointer& operator=(const HazardPointer&) = delete;
+        HazardPointer& operator=(HazardPointer&&) = delete;
+
+        // Loads the pointer from the source and publishes it. Returns the pointer, which stays valid until
+        // the next Protect or Reset call
+        template<typename T>
+        T* Protect(const std::atomic<T*>& source) noexcept;
+
+        void Reset() noexcept;
+
+        ~HazardPointer();
+
+    private:
+        details::HazardRecord* record_;
+    };
+
+    // The node is deleted, when no HazardPointer protects it. The node must be unreachable for the new Protect calls
+    template<typename T>
+    void Retire(T* node);
+
+
+    // Implementation
+
+    namespace details {
+
+        inline HazardRecord* HazardDomain::AcquireRecord() {
+            for (HazardRecord& record : records_) {
+                bool is_owned = false;
+                if (!record.is_owned_.load(std::memory_order_relaxed) &&
+                    record.is_owned_.compare_exchange_strong(is_owned, true, std::memory_order_acquire)) {
+                    return &record;
+                }
+            }
+            throw std::runtime_error("Too many threads use the hazard pointers");
+        }
+
+        inline void HazardDomain::ReleaseRecord(HazardRecord* record) noexcept {
+            record->pointer_.store(nullptr, std::memory_order_release);
+            record->is_owned_.store(false, std::memory_order_release);
+        }
+
+        inline void HazardDomain::Reclaim(std::vector<RetiredNode>& retired) {
+            {
+                std::unique_lock lock(orphans_mutex_, std::try_to_lock);
+                if (lock.owns_lock() && !orphans_.empty()) {
+                    retired.insert(retired.end(), orphans_.begin(), orphans_.end());
+                    orphans_.clear();
+                }
+            }
+
+            // Pairs with the seq_cst store in Protect: either the node is seen here, or Protect sees that it was unlinked
+            std::vector<void*> hazards;
+            hazards.reserve(kMaxHazardPointersCount);
+            for (HazardRecord& record : records_) {
+                if (void* pointer = record.pointer_.load(std::memory_order_seq_cst)) {
+                    hazards.push_back(pointer);
+                }
+            }
+            std::sort(hazards.begin(), hazards.end());
+
+            auto protected_end = std::partition(retired.begin(), retired.end(), [&hazards](const RetiredNode& node) {
+                return std::binary_search(hazards.begin(), hazards.end(), node.pointer_);
+            });
+            for (auto it = protected_end; it != retired.end(); ++it) {
+                it->deleter_(it->pointer_);
+            }
+            retired.erase(protected_end, retired.end());
+        }
+
+        inline void HazardDomain::AddOrphans(std::vector<RetiredNode>& retired) {
+            std::lock_guard lock(orphans_mutex_);
+            orphans_.insert(orphans_.end(), retired.begin(), retired.end());
+            retired.clear();
+        }
+
+        inline HazardDomain::~HazardDomain() {
+            for (RetiredNode& node : orphans_) {
+                node.deleter_(node.pointer_);
+            }
+        }
+
+        inline HazardDomain& GetHazardDomain() {
+            static HazardDomain domain;
+            return domain;
+        }
+
+        inline HazardRecord* ThreadContext::AcquireRecord() {
+            if (!free_records_) {
+                return GetHazardDomain().AcquireRecord();
+            }
+
+            HazardRecord* record = free_records_;
+            free_records_ = record->next_free_;
+            return record;
+        }
+
+        inline void ThreadContext::ReleaseRecord(HazardRecord* record) noexcept {
+            record->pointer_.store(nullptr, std::memory_order_release);
+            record->next_free_ = free_records_;
+            free_records_ = record;
+        }
+
+        inline void ThreadContext::Retire(RetiredNode node) {
+            retired_.push_back(node);
+            if (retired_.size() >= kRetiredScanThreshold) {
+                GetHazardDomain().Reclaim(retired_);
+            }
+        }
+
+        inline ThreadContext::~ThreadContext() {
+            HazardDomain& domain = GetHazardDomain();
+            while (free_records_) {
+                HazardRecord* record = free_records_;
+                free_records_ = record->next_free_;
+                domain.ReleaseRecord(record);
+            }
+            domain.Reclaim(retired_);
+            if (!retired_.empty()) {
+                domain.AddOrphans(retired_);
+            }
+        }
+
+        inline ThreadContext& GetThreadContext() {
+            GetHazardDomain(); // The domain is constructed before and destroyed after the context
+            thread_local ThreadContext context;
+            return context;
+        }
+
+    }
+
+    inline HazardPointer::HazardPointer() : record_(details::GetThreadContext().AcquireRecord()) {}
+
+    template<typename T>
+    T* HazardPointer::Protect(const std::atomic<T*>& source) noexcept {
+        T* pointer = source.load(std::memory_order_acquire);
+        while (true) {
+            record_->pointer_.store(pointer, std::memory_order_seq_cst);
+            T* new_pointer = source.load(std::memory_order_seq_cst);
+            if (pointer == new_pointer) {
+                return pointer;
+            }
+            pointer = new_pointer;
+        }
+    }
+
+    inline void HazardPointer::Reset() noexcept {
+        record_->pointer_.store(nullptr, std::memory_order_release);
+    }
+
+    inline HazardPointer::~HazardPointer() {
+        details::GetThreadContext().ReleaseRecord(record_);
+    }
+
+    template<typename T>
+    void Retire(T* node) {
+        details::GetThreadContext().Retire({node, [](void* pointer) { delete static_cast<T*>(pointer); }});
+    }
+
+} // End of namespace concurrent::reclamation
+
+#endif //LOCK_FREE_DATA_STRUCTURES_HAZARD_POINTER_H
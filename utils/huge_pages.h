@@ -1,6 +1,8 @@
 #ifndef LOCK_FREE_DATA_STRUCTURES_HUGE_PAGES_H
 #define LOCK_FREE_DATA_STRUCTURES_HUGE_PAGES_H
 
+#include <new>
+#include <cstddef>
 #include <sys/mman.h>
 
 
@@ -15,6 +17,9 @@ namespace concurrent::allocator {
 
         inline constexpr int kMMapFlags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
 
+        // Used if there are no reserved huge pages in the system. Then transparent huge pages are requested
+        inline constexpr int kMMapFallbackFlags = MAP_PRIVATE | MAP_ANONYMOUS;
+
     }
 
     template<typename T>
@@ -25,11 +30,10 @@ namespace concurrent::allocator {
 
         HugePageAllocator() = default;
 
+        HugePageAllocator(const HugePageAllocator&) = default;
         template<typename U>
         HugePageAllocator(const HugePageAllocator<U>&) noexcept;
-        HugePageAllocator(HugePageAllocator&&) = delete;
         HugePageAllocator& operator=(const HugePageAllocator&);
-        HugePageAllocator& operator=(HugePageAllocator&&) = delete;
 
         pointer allocate(std::size_t n);
         void deallocate(pointer pointer, std::size_t n);
@@ -39,11 +43,11 @@ namespace concurrent::allocator {
 
     };
 
-    template<typename T>
-    bool operator==(const HugePageAllocator<T>&, const HugePageAllocator<T>&);
+    template<typename T, typename U>
+    bool operator==(const HugePageAllocator<T>&, const HugePageAllocator<U>&);
 
-    template<typename T>
-    bool operator!=(const HugePageAllocator<T>&, const HugePageAllocator<T>&);
+    template<typename T, typename U>
+    bool operator!=(const HugePageAllocator<T>&, const HugePageAllocator<U>&);
 
 
     // Implementation
@@ -57,19 +61,26 @@ namespace concurrent::allocator {
     }
 
     template<typename T>
-    HugePageAllocator<T>::pointer HugePageAllocator<T>::allocate(std::size_t n) {
-        auto ptr = static_cast<pointer>(mmap(nullptr, GetHugePageSize(n * sizeof(T)),
-                                             details::huge_page_allocator::kMMapProt,
-                                             details::huge_page_allocator::kMMapFlags, -1, 0));
+    typename HugePageAllocator<T>::pointer HugePageAllocator<T>::allocate(std::size_t n) {
+        using namespace details::huge_page_allocator;
+        const std::size_t size = GetHugePageSize(n * sizeof(T));
+
+        void* ptr = mmap(nullptr, size, kMMapProt, kMMapFlags, -1, 0);
         if (ptr == MAP_FAILED) {
-            throw std::bad_alloc();
+            ptr = mmap(nullptr, size, kMMapProt, kMMapFallbackFlags, -1, 0);
+            if (ptr == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+#ifdef MADV_HUGEPAGE
+            madvise(ptr, size, MADV_HUGEPAGE);
+#endif
         }
-        return ptr;
+        return static_cast<pointer>(ptr);
     }
 
     template<typename T>
     void HugePageAllocator<T>::deallocate(HugePageAllocator::pointer pointer, std::size_t n) {
-        munmap(pointer, GetHugePageSize(n));
+        munmap(pointer, GetHugePageSize(n * sizeof(T)));
     }
 
     template<typename T>
@@ -79,13 +90,13 @@ namespace concurrent::allocator {
     }
 
 
-    template<typename T>
-    bool operator==(const HugePageAllocator<T>&, const HugePageAllocator<T>&) {
+    template<typename T, typename U>
+    bool operator==(const HugePageAllocator<T>&, const HugePageAllocator<U>&) {
         return true;
     }
 
-    template<typename T>
-    bool operator!=(const HugePageAllocator<T>&, const HugePageAllocator<T>&) {
+    template<typename T, typename U>
+    bool operator!=(const HugePageAllocator<T>&, const HugePageAllocator<U>&) {
         return false;
     }
 
@@ -0,0 +1,122 @@
+#ifndef LOCK_FREE_INSTRUMENTATION_H
+#define LOCK_FREE_INSTRUMENTATION_H
+
+#include <atomic>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+#include "cache_line.h"
+
+namespace concurrent::instrumentation {
+
+    // The events, which show why the operation of the structure is slow
+    enum class Event : std::size_t {
+        kFullRejection,     // TryEnqueue (TryEmplace) returned false, because the queue is full
+        kEmptyRejection,    // TryDequeue returned false, because the queue is empty
+        kCasRetry,          // The CAS on the shared index failed and was retried
+        kGenerationSpin,    // The blocking operation checked the generation of its slot, and it was not ready
+        kCachedHeadRefresh, // The producer reloaded the head of the consumer, because the cached head showed the full queue
+        kCachedTailRefresh, // The consumer reloaded the tail of the producer, because the cached tail showed the empty queue
+        kReaderLapped,      // The reader found its message overwritten by the writer
+        kLockSpin,          // The lock was taken, and the thread spun once waiting for it
+
+        kEventsCount
+    };
+
+    inline constexpr std::size_t kEventsCount = static_cast<std::size_t>(Event::kEventsCount);
+
+    // The number of the cells of ContentionCounters. The threads, whose numbers differ by it, share the cell
+    inline constexpr std::size_t kDefaultCellsCount = 64;
+
+    // The sum of the counters of all threads at the moment of GetSnapshot
+    struct ContentionSnapshot {
+        [[nodiscard]] std::uint64_t Get(Event event) const noexcept;
+
+        std::array<std::uint64_t, kEventsCount> counts_{};
+    };
+
+    // The instrumentation policy, which counts nothing. Add is empty and the policy takes no space
+    // in the structure ([[no_unique_address]]), so the instrumentation costs nothing when it is off
+    struct NoCounters {
+        static constexpr bool kIsEnabled = false;
+
+        void Add(Event, std::uint64_t = 1) noexcept {}
+
+        [[nodiscard]] ContentionSnapshot GetSnapshot() const noexcept {
+            return {};
+        }
+    };
+
+    // The instrumentation policy, which counts the events in the per-thread cells. Every cell is on its own cache line,
+    // so the threads do not share the lines on the hot path. GetSnapshot sums the cells with the relaxed loads,
+    // so the snapshot is not atomic across the counters
+    template<std::size_t CellsCount = kDefaultCellsCount>
+    class ContentionCounters {
+    public:
+        static constexpr bool kIsEnabled = true;
+
+        ContentionCounters() = default;
+
+        ContentionCounters(const ContentionCounters&) = delete;
+        ContentionCounters(ContentionCounters&&) = delete;
+        ContentionCounters& operator=(const ContentionCounters&) = delete;
+        ContentionCounters& operator=(ContentionCounters&&) = delete;
+
+        void Add(Event event, std::uint64_t count = 1) noexcept;
+
+        [[nodiscard]] ContentionSnapshot GetSnapshot() const noexcept;
+
+        ~ContentionCounters() = default;
+
+    private:
+        struct alignas(cache::kCacheLineSize) Cell {
+            std::array<std::atomic<std::uint64_t>, kEventsCount> counts_{};
+        };
+
+        std::array<Cell, CellsCount> cells_{};
+    };
+
+    namespace details {
+
+        // The number of the current thread, which selects its cell
+        std::size_t GetThreadNumber() noexcept;
+
+    }
+
+
+    // Implementation
+    inline std::uint64_t ContentionSnapshot::Get(Event event) const noexcept {
+        return counts_[static_cast<std::size_t>(event)];
+    }
+
+    namespace details {
+
+        inline std::size_t GetThreadNumber() noexcept {
+            static std::atomic<std::size_t> threads_count{0};
+            static thread_local const std::size_t thread_number = threads_count.fetch_add(1, std::memory_order_relaxed);
+            return thread_number;
+        }
+
+    }
+
+    template<std::size_t CellsCount>
+    void ContentionCounters<CellsCount>::Add(Event event, std::uint64_t count) noexcept {
+        // The cell is written by one thread, unless there are more than CellsCount threads, so fetch_add is not contended
+        cells_[details::GetThreadNumber() % CellsCount].counts_[static_cast<std::size_t>(event)].fetch_add(count, std::memory_order_relaxed);
+    }
+
+    template<std::size_t CellsCount>
+    ContentionSnapshot ContentionCounters<CellsCount>::GetSnapshot() const noexcept {
+        ContentionSnapshot snapshot;
+        for (const Cell& cell : cells_) {
+            for (std::size_t i = 0; i < kEventsCount; ++i) {
+                snapshot.counts_[i] += cell.counts_[i].load(std::memory_order_relaxed);
+            }
+        }
+        return snapshot;
+    }
+
+} // End of namespace concurrent::instrumentation
+
+#endif //LOCK_FREE_INSTRUMENTATION_H
@@ -0,0 +1,33 @@
+#ifndef LOCK_FREE_DATA_STRUCTURES_RANDOM_H
+#define LOCK_FREE_DATA_STRUCTURES_RANDOM_H
+
+#include <cstdint>
+
+namespace concurrent::utils {
+
+    // xorshift64 generator. It is not thread-safe, so every thread keeps its own. Good enough to pick
+    // the victims of stealing, and costs three shifts per number. The seed must not be 0
+    class XorShift64Random {
+    public:
+        explicit XorShift64Random(std::uint64_t seed) noexcept;
+
+        std::uint64_t Next() noexcept;
+
+    private:
+        std::uint64_t state_;
+    };
+
+
+    // Implementation
+    inline XorShift64Random::XorShift64Random(std::uint64_t seed) noexcept : state_(seed) {}
+
+    inline std::uint64_t XorShift64Random::Next() noexcept {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 7;
+        state_ ^= state_ << 17;
+        return state_;
+    }
+
+} // End of namespace concurrent::utils
+
+#endif //LOCK_FREE_DATA_STRUCTURES_RANDOM_H
@@ -1,7 +1,22 @@
 #ifndef LOCK_FREE_DATA_STRUCTURES_WAIT_H
 #define LOCK_FREE_DATA_STRUCTURES_WAIT_H
 
+#include <atomic>
 #include <thread>
+#include <chrono>
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstddef>
+
+#ifdef __linux__
+#include <ctime>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+#include "cache_line.h"
 
 #if defined(_M_X64)
 #define CONCURRENT_WAIT __builtin_ia32_pause()
@@ -25,6 +40,279 @@ namespace concurrent::wait {
         }
     }
 
+    inline constexpr std::size_t kDefaultSpinCount = 1024;
+
+    // Wait strategies are passed to the queues as the WaitStrategy template parameter.
+    // The waiting side calls Wait(condition), which returns when condition() is true,
+    // or WaitUntil(condition, deadline), which also gives up at the deadline and returns the last result of condition().
+    // The other side calls Notify() after every change that can make the condition true, or NotifyOne(),
+    // if the change can be consumed by one waiter only
+
+    // Spins until the condition is true. It has the lowest latency, but burns a full core while waiting
+    class BusySpinWaitStrategy {
+    public:
+        template<typename Condition>
+        void Wait(Condition&& condition);
+
+        template<typename Condition, typename Clock, typename Duration>
+        bool WaitUntil(Condition&& condition, const std::chrono::time_point<Clock, Duration>& deadline);
+
+        void Notify() noexcept {}
+        void NotifyOne() noexcept {}
+    };
+
+    // Spins SpinCount iterations, then yields the core to the other threads between the checks
+    template<std::size_t SpinCount = kDefaultSpinCount>
+    class SpinYieldWaitStrategy {
+    public:
+        template<typename Condition>
+        void Wait(Condition&& condition);
+
+        template<typename Condition, typename Clock, typename Duration>
+        bool WaitUntil(Condition&& condition, const std::chrono::time_point<Clock, Duration>& deadline);
+
+        void Notify() noexcept {}
+        void NotifyOne() noexcept {}
+    };
+
+    // Spins SpinCount iterations, then parks the thread on the futex. WaitUntil parks with the timeout of the time
+    // left to the deadline. The waiters counter lets Notify() skip the system call when nobody sleeps
+    template<std::size_t SpinCount = kDefaultSpinCount>
+    class SpinParkWaitStrategy {
+    public:
+        template<typename Condition>
+        void Wait(Condition&& condition);
+
+        template<typename Condition, typename Clock, typename Duration>
+        bool WaitUntil(Condition&& condition, const std::chrono::time_point<Clock, Duration>& deadline);
+
+        void Notify() noexcept;
+        void NotifyOne() noexcept;
+
+    private:
+        alignas(cache::kCacheLineSize) std::atomic<std::uint32_t> epoch_{0};
+        std::atomic<std::uint32_t> waiters_count_{0};
+
+        PADDING(padding_, 2 * sizeof(std::atomic<std::uint32_t>));
+    };
+
+
+    namespace details {
+
+        // Parks the thread while word is equal to expected. Can return spuriously
+        inline void Park(std::atomic<std::uint32_t>& word, std::uint32_t expected);
+
+        // Parks the thread while word is equal to expected, but not longer than timeout. Can return spuriously
+        inline void ParkFor(std::atomic<std::uint32_t>& word, std::uint32_t expected, std::chrono::nanoseconds timeout);
+
+        // Wakes up all threads parked on word
+        inline void UnparkAll(std::atomic<std::uint32_t>& word);
+
+        // Wakes up one thread parked on word
+        inline void UnparkOne(std::atomic<std::uint32_t>& word);
+
+        // Without the futex the timed park sleeps and polls the word, so the sleep is bounded by the period
+        inline constexpr std::chrono::microseconds kParkPollPeriod{50};
+
+    }
+
+
+    // Implementation
+    namespace details {
+
+#ifdef __linux__
+        static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t) && std::atomic<std::uint32_t>::is_always_lock_free,
+                      "The futex is used on the atomic word directly");
+
+        // Both the timed and the untimed waits use the raw futex, because std::atomic::notify_all can skip
+        // the wake up of the threads, which are not parked with std::atomic::wait
+        inline void Park(std::atomic<std::uint32_t>& word, std::uint32_t expected) {
+            syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+        }
+
+        inline void ParkFor(std::atomic<std::uint32_t>& word, std::uint32_t expected, std::chrono::nanoseconds timeout) {
+            const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+            timespec relative_timeout{};
+            relative_timeout.tv_sec = static_cast<time_t>(seconds.count());
+            relative_timeout.tv_nsec = static_cast<long>((timeout - seconds).count());
+            syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, &relative_timeout, nullptr, 0);
+        }
+
+        inline void UnparkAll(std::atomic<std::uint32_t>& word) {
+            syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+        }
+
+        inline void UnparkOne(std::atomic<std::uint32_t>& word) {
+            syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+        }
+#else
+        inline void Park(std::atomic<std::uint32_t>& word, std::uint32_t expected) {
+            word.wait(expected, std::memory_order_seq_cst);
+        }
+
+        inline void ParkFor(std::atomic<std::uint32_t>& word, std::uint32_t expected, std::chrono::nanoseconds timeout) {
+            if (word.load(std::memory_order_seq_cst) == expected) {
+                std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(timeout, kParkPollPeriod));
+            }
+        }
+
+        inline void UnparkAll(std::atomic<std::uint32_t>& word) {
+            word.notify_all();
+        }
+
+        inline void UnparkOne(std::atomic<std::uint32_t>& word) {
+            word.notify_one();
+        }
+#endif
+
+    }
+
+    template<typename Condition>
+    void BusySpinWaitStrategy::Wait(Condition&& condition) {
+        while (!condition()) {
+            concurrent::wait::Wait();
+        }
+    }
+
+    template<typename Condition, typename Clock, typename Duration>
+    bool BusySpinWaitStrategy::WaitUntil(Condition&& condition, const std::chrono::time_point<Clock, Duration>& deadline) {
+        while (!condition()) {
+            if (Clock::now() >= deadline) {
+                return condition();
+            }
+            concurrent::wait::Wait();
+        }
+        return true;
+    }
+
+
+    template<std::size_t SpinCount>
+    template<typename Condition>
+    void SpinYieldWaitStrategy<SpinCount>::Wait(Condition&& condition) {
+        for (std::size_t i = 0; i < SpinCount; ++i) {
+            if (condition()) {
+                return;
+            }
+            concurrent::wait::Wait();
+        }
+
+        while (!condition()) {
+            std::this_thread::yield();
+        }
+    }
+
+    template<std::size_t SpinCount>
+    template<typename Condition, typename Clock, typename Duration>
+    bool SpinYieldWaitStrategy<SpinCount>::WaitUntil(Condition&& condition, const std::chrono::time_point<Clock, Duration>& deadline) {
+        for (std::size_t i = 0; i < SpinCount; ++i) {
+            if (condition()) {
+                return true;
+            }
+            if (Clock::now() >= deadline) {
+                return condition();
+            }
+            concurrent::wait::Wait();
+        }
+
+        while (!condition()) {
+            if (Clock::now() >= deadline) {
+                return condition();
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+
+    template<std::size_t SpinCount>
+    template<typename Condition>
+    void SpinParkWaitStrategy<SpinCount>::Wait(Condition&& condition) {
+        for (std::size_t i = 0; i < SpinCount; ++i) {
+            if (condition()) {
+                return;
+            }
+            concurrent::wait::Wait();
+        }
+
+        while (true) {
+            // The waiter is registered before the condition is checked, so the notifier
+            // either sees the waiter or the waiter sees the change
+            waiters_count_.fetch_add(1, std::memory_order_seq_cst);
+            const std::uint32_t epoch = epoch_.load(std::memory_order_seq_cst);
+
+            if (condition()) {
+                waiters_count_.fetch_sub(1, std::memory_order_relaxed);
+                return;
+            }
+
+            details::Park(epoch_, epoch);
+            waiters_count_.fetch_sub(1, std::memory_order_relaxed);
+
+            if (condition()) {
+                return;
+            }
+        }
+    }
+
+    template<std::size_t SpinCount>
+    template<typename Condition, typename Clock, typename Duration>
+    bool SpinParkWaitStrategy<SpinCount>::WaitUntil(Condition&& condition, const std::chrono::time_point<Clock, Duration>& deadline) {
+        for (std::size_t i = 0; i < SpinCount; ++i) {
+            if (condition()) {
+                return true;
+            }
+            if (Clock::now() >= deadline) {
+                return condition();
+            }
+            concurrent::wait::Wait();
+        }
+
+        while (true) {
+            waiters_count_.fetch_add(1, std::memory_order_seq_cst);
+            const std::uint32_t epoch = epoch_.load(std::memory_order_seq_cst);
+
+            if (condition()) {
+                waiters_count_.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+
+            const auto timeout = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - Clock::now());
+            if (timeout <= std::chrono::nanoseconds::zero()) {
+                waiters_count_.fetch_sub(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            details::ParkFor(epoch_, epoch, timeout);
+            waiters_count_.fetch_sub(1, std::memory_order_relaxed);
+
+            if (condition()) {
+                return true;
+            }
+        }
+    }
+
+    template<std::size_t SpinCount>
+    void SpinParkWaitStrategy<SpinCount>::Notify() noexcept {
+        // Orders the preceding publication with the load of the waiters counter
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (waiters_count_.load(std::memory_order_relaxed)) {
+            epoch_.fetch_add(1, std::memory_order_seq_cst);
+            details::UnparkAll(epoch_);
+        }
+    }
+
+    template<std::size_t SpinCount>
+    void SpinParkWaitStrategy<SpinCount>::NotifyOne() noexcept {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        // The other parked threads keep waiting for the old epoch, until they are woken up
+        if (waiters_count_.load(std::memory_order_relaxed)) {
+            epoch_.fetch_add(1, std::memory_order_seq_cst);
+            details::UnparkOne(epoch_);
+        }
+    }
+
 }
 
 #endif //LOCK_FREE_DATA_STRUCTURES_WAIT_H